@@ -0,0 +1,32 @@
+#include "Arena.h"
+
+namespace
+{
+    /* blocks big enough for the buffers of a face or a solid */
+    const size_t blockSize = 256 * 1024;
+
+    thread_local int scopeDepth = 0;
+
+    Handle(NCollection_IncAllocator)& threadAllocator()
+    {
+        thread_local Handle(NCollection_IncAllocator) anAllocator = new NCollection_IncAllocator(blockSize);
+        return anAllocator;
+    }
+}
+
+Arena::Scope::Scope()
+{
+    scopeDepth++;
+}
+
+Arena::Scope::~Scope()
+{
+    /* nested operations share the arena, only the outermost one resets it */
+    if (--scopeDepth == 0)
+        threadAllocator()->Reset(Standard_False);
+}
+
+const Handle(NCollection_IncAllocator)& Arena::allocator()
+{
+    return threadAllocator();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <NCollection_IncAllocator.hxx>
+#include <NCollection_StdAllocator.hxx>
+
+/*
+* Arena hands out the bump allocator of the calling thread for transient
+* buffers of one operation. Allocating is a pointer increment with no lock
+* and freeing is a no-op; the memory comes back at once when the outermost
+* Arena::Scope of the thread ends, and its blocks are kept for the next
+* operation. Nothing allocated in a scope may outlive it.
+*/
+class Arena
+{
+public:
+	class Scope
+	{
+	public:
+		Scope();
+		~Scope();
+	};
+
+	/* valid on this thread only, inside a Scope */
+	static const Handle(NCollection_IncAllocator)& allocator();
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, NCollection_StdAllocator<T>>;
+
+/* an empty vector backed by the thread's arena */
+template <typename T>
+ArenaVector<T> arenaVector()
+{
+	return ArenaVector<T>(NCollection_StdAllocator<T>(Arena::allocator()));
+}
@@ -0,0 +1,473 @@
+#include "AssemblyLoader.h"
+#include "StepLoader.h"
+#include "TaskScheduler.h"
+#include "Tracer.h"
+#include <map>
+#include <chrono>
+#include <algorithm>
+
+#include <gp_Ax3.hxx>
+#include <BRep_Tool.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <IMeshTools_Parameters.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopLoc_Location.hxx>
+#include <TopoDS.hxx>
+#include <Precision.hxx>
+#include <TColStd_MapOfTransient.hxx>
+#include <TColStd_SequenceOfAsciiString.hxx>
+
+#include <Interface_Graph.hxx>
+#include <Interface_EntityIterator.hxx>
+#include <XSControl_WorkSession.hxx>
+#include <XSControl_TransferReader.hxx>
+#include <StepData_StepModel.hxx>
+#include <StepBasic_Product.hxx>
+#include <StepBasic_ProductDefinition.hxx>
+#include <StepBasic_ProductDefinitionFormation.hxx>
+#include <StepRepr_NextAssemblyUsageOccurrence.hxx>
+#include <StepRepr_ProductDefinitionShape.hxx>
+#include <StepRepr_PropertyDefinition.hxx>
+#include <StepRepr_Representation.hxx>
+#include <StepRepr_ShapeRepresentationRelationship.hxx>
+#include <StepRepr_RepresentationRelationshipWithTransformation.hxx>
+#include <StepRepr_ItemDefinedTransformation.hxx>
+#include <StepShape_ShapeDefinitionRepresentation.hxx>
+#include <StepShape_ContextDependentShapeRepresentation.hxx>
+#include <StepGeom_Axis2Placement3d.hxx>
+#include <StepGeom_CartesianPoint.hxx>
+#include <StepGeom_Direction.hxx>
+#include <StepGeom_Circle.hxx>
+#include <StepGeom_SphericalSurface.hxx>
+#include <StepGeom_ToroidalSurface.hxx>
+
+typedef std::chrono::steady_clock Clock;
+typedef std::map<const Standard_Transient*, Handle(Standard_Transient)> EntityMap;
+
+static gp_Pnt stepPoint(const Handle(StepGeom_CartesianPoint)& pnt, double factor)
+{
+    double xyz[3] = { 0.0, 0.0, 0.0 };
+    for (int i = 1; i <= std::min(3, pnt->NbCoordinates()); i++)
+        xyz[i - 1] = pnt->CoordinatesValue(i) * factor;
+    return gp_Pnt(xyz[0], xyz[1], xyz[2]);
+}
+
+static gp_Dir stepDir(const Handle(StepGeom_Direction)& dir, const gp_Dir& fallback)
+{
+    if (dir.IsNull() || dir->NbDirectionRatios() < 3)
+        return fallback;
+    gp_XYZ xyz(dir->DirectionRatiosValue(1), dir->DirectionRatiosValue(2), dir->DirectionRatiosValue(3));
+    return xyz.Modulus() > gp::Resolution() ? gp_Dir(xyz) : fallback;
+}
+
+static gp_Ax3 stepAx3(const Handle(StepGeom_Axis2Placement3d)& ax, double factor)
+{
+    gp_Pnt origin = stepPoint(ax->Location(), factor);
+    gp_Dir zDir = ax->HasAxis() ? stepDir(ax->Axis(), gp::DZ()) : gp::DZ();
+    if (ax->HasRefDirection())
+    {
+        gp_Dir xDir = stepDir(ax->RefDirection(), gp::DX());
+        if (!zDir.IsParallel(xDir, Precision::Angular()))
+            return gp_Ax3(origin, zDir, xDir);
+    }
+    return gp_Ax3(origin, zDir);
+}
+
+/* millimetres per file length unit */
+static double unitFactor(const TCollection_AsciiString& unit)
+{
+    TCollection_AsciiString name = unit;
+    name.UpperCase();
+    if (name == "MM" || name == "MILLIMETRE")
+        return 1.0;
+    if (name == "CM" || name == "CENTIMETRE")
+        return 10.0;
+    if (name == "M" || name == "METRE")
+        return 1000.0;
+    if (name == "KM" || name == "KILOMETRE")
+        return 1.0e6;
+    if (name == "UM" || name == "MICROMETRE")
+        return 1.0e-3;
+    if (name == "INCH" || name == "IN")
+        return 25.4;
+    if (name == "FT" || name == "FOOT")
+        return 304.8;
+    return 1.0;
+}
+
+static std::string productName(const Handle(StepBasic_ProductDefinition)& pd)
+{
+    if (pd->Formation().IsNull() || pd->Formation()->OfProduct().IsNull()
+        || pd->Formation()->OfProduct()->Name().IsNull())
+        return std::string();
+    return pd->Formation()->OfProduct()->Name()->ToCString();
+}
+
+/* rough memory of a transferred and meshed shape */
+static size_t shapeBytes(const TopoDS_Shape& shp)
+{
+    size_t bytes = 0;
+    for (TopExp_Explorer exp(shp, TopAbs_FACE); exp.More(); exp.Next())
+    {
+        bytes += 1024;  //surface, wires and edges of the face
+        TopLoc_Location aLoc;
+        Handle(Poly_Triangulation) triMesh = BRep_Tool::Triangulation(TopoDS::Face(exp.Current()), aLoc);
+        if (!triMesh.IsNull())
+            bytes += triMesh->NbNodes() * (sizeof(gp_Pnt) + sizeof(gp_Pnt2d))
+                + triMesh->NbTriangles() * sizeof(Poly_Triangle);
+    }
+    return bytes;
+}
+
+AssemblyLoader::AssemblyLoader(const std::string& fileName)
+    : fileName(fileName),
+    lengthFactor(1.0),
+    memoryCap(size_t(1) << 30),
+    usedBytes(0),
+    useClock(0),
+    deviationCoefficient(0.001),
+    deviationAngle(20.0 * M_PI / 180.0),
+    readMs(0.0)
+{
+
+}
+
+AssemblyLoader::~AssemblyLoader()
+{
+
+}
+
+bool AssemblyLoader::read()
+{
+    Tracer::Span span("read assembly", "load");
+    Clock::time_point start = Clock::now();
+    parts.clear();
+    nodes.clear();
+    if (stepReader.ReadFile(fileName.c_str()) != IFSelect_RetDone)
+        return false;
+
+    TColStd_SequenceOfAsciiString lengthNames, angleNames, solidAngleNames;
+    stepReader.FileUnits(lengthNames, angleNames, solidAngleNames);
+    if (lengthNames.Length() > 0)
+        lengthFactor = unitFactor(lengthNames.First());
+
+    /*
+    * one pass over the model: the shape definition of each product, the
+    * assembly links, and the placement of each link
+    */
+    Handle(StepData_StepModel) aModel = stepReader.StepModel();
+    EntityMap sdrOf;        //product definition -> shape definition representation
+    std::map<const Standard_Transient*, vector<Handle(StepRepr_NextAssemblyUsageOccurrence)>> children;
+    std::set<const Standard_Transient*> hasParent;
+    vector<Handle(StepShape_ContextDependentShapeRepresentation)> placements;
+    for (Standard_Integer i = 1; i <= aModel->NbEntities(); i++)
+    {
+        Handle(Standard_Transient) anEntity = aModel->Value(i);
+        if (Handle(StepShape_ShapeDefinitionRepresentation) sdr = Handle(StepShape_ShapeDefinitionRepresentation)::DownCast(anEntity))
+        {
+            Handle(StepRepr_PropertyDefinition) prop = sdr->Definition().PropertyDefinition();
+            if (prop.IsNull() || sdr->UsedRepresentation().IsNull())
+                continue;
+            Handle(StepBasic_ProductDefinition) pd = prop->Definition().ProductDefinition();
+            if (!pd.IsNull())
+                sdrOf[pd.get()] = sdr;
+        }
+        else if (Handle(StepRepr_NextAssemblyUsageOccurrence) nauo = Handle(StepRepr_NextAssemblyUsageOccurrence)::DownCast(anEntity))
+        {
+            if (nauo->RelatingProductDefinition().IsNull() || nauo->RelatedProductDefinition().IsNull())
+                continue;
+            children[nauo->RelatingProductDefinition().get()].push_back(nauo);
+            hasParent.insert(nauo->RelatedProductDefinition().get());
+        }
+        else if (Handle(StepShape_ContextDependentShapeRepresentation) cdsr = Handle(StepShape_ContextDependentShapeRepresentation)::DownCast(anEntity))
+        {
+            placements.push_back(cdsr);
+        }
+    }
+
+    /* placement of each link, from child to parent coordinates */
+    std::map<const Standard_Transient*, gp_Trsf> linkTrsf;
+    for (const Handle(StepShape_ContextDependentShapeRepresentation)& cdsr : placements)
+    {
+        Handle(StepRepr_ProductDefinitionShape) pds = cdsr->RepresentedProductRelation();
+        Handle(StepRepr_RepresentationRelationshipWithTransformation) rrwt =
+            Handle(StepRepr_RepresentationRelationshipWithTransformation)::DownCast(cdsr->RepresentationRelation());
+        if (pds.IsNull() || rrwt.IsNull())
+            continue;
+        Handle(StepBasic_ProductDefinitionRelationship) link = pds->Definition().ProductDefinitionRelationship();
+        Handle(StepRepr_ItemDefinedTransformation) idt = rrwt->TransformationOperator().ItemDefinedTransformation();
+        if (link.IsNull() || idt.IsNull())
+            continue;
+        Handle(StepGeom_Axis2Placement3d) ax1 = Handle(StepGeom_Axis2Placement3d)::DownCast(idt->TransformItem1());
+        Handle(StepGeom_Axis2Placement3d) ax2 = Handle(StepGeom_Axis2Placement3d)::DownCast(idt->TransformItem2());
+        if (ax1.IsNull() || ax2.IsNull())
+            continue;
+
+        /* rep_1 is normally the child, some writers swap them */
+        gp_Trsf trsf;
+        EntityMap::const_iterator childSdr = sdrOf.find(link->RelatedProductDefinition().get());
+        bool isSwapped = childSdr != sdrOf.end() && rrwt->Rep2()
+            == Handle(StepShape_ShapeDefinitionRepresentation)::DownCast(childSdr->second)->UsedRepresentation();
+        if (isSwapped)
+            trsf.SetDisplacement(stepAx3(ax2, lengthFactor), stepAx3(ax1, lengthFactor));
+        else
+            trsf.SetDisplacement(stepAx3(ax1, lengthFactor), stepAx3(ax2, lengthFactor));
+        linkTrsf[link.get()] = trsf;
+    }
+
+    /* flatten the tree from every root product, leaves become parts */
+    struct Visit
+    {
+        Handle(StepBasic_ProductDefinition) pd;
+        gp_Trsf trsf;
+        std::string path;
+        int depth;
+    };
+    std::map<const Standard_Transient*, int> partOf;
+    vector<Visit> stack;
+    for (const EntityMap::value_type& entry : sdrOf)
+    {
+        if (hasParent.count(entry.first) == 0)
+        {
+            Handle(StepShape_ShapeDefinitionRepresentation) sdr = Handle(StepShape_ShapeDefinitionRepresentation)::DownCast(entry.second);
+            Handle(StepBasic_ProductDefinition) pd = sdr->Definition().PropertyDefinition()->Definition().ProductDefinition();
+            stack.push_back(Visit{ pd, gp_Trsf(), productName(pd), 0 });
+        }
+    }
+    while (!stack.empty())
+    {
+        Visit visit = stack.back();
+        stack.pop_back();
+
+        auto links = children.find(visit.pd.get());
+        if (links != children.end() && visit.depth < 64)  //64 guards a cyclic file
+        {
+            for (const Handle(StepRepr_NextAssemblyUsageOccurrence)& nauo : links->second)
+            {
+                auto placement = linkTrsf.find(nauo.get());
+                gp_Trsf trsf = placement == linkTrsf.end() ? visit.trsf : visit.trsf * placement->second;
+                Handle(StepBasic_ProductDefinition) child = nauo->RelatedProductDefinition();
+                stack.push_back(Visit{ child, trsf, visit.path + "/" + productName(child), visit.depth + 1 });
+            }
+            continue;
+        }
+
+        EntityMap::const_iterator sdr = sdrOf.find(visit.pd.get());
+        if (sdr == sdrOf.end())
+            continue;
+        auto found = partOf.find(visit.pd.get());
+        if (found == partOf.end())
+        {
+            AssemblyPart aPart;
+            aPart.name = productName(visit.pd);
+            aPart.definition = sdr->second;
+            aPart.box = estimateBox(sdr->second);
+            parts.push_back(aPart);
+            found = partOf.emplace(visit.pd.get(), static_cast<int>(parts.size()) - 1).first;
+        }
+
+        AssemblyNode aNode;
+        aNode.part = found->second;
+        aNode.path = visit.path;
+        aNode.location = visit.trsf;
+        aNode.box = parts[aNode.part].box.Transformed(visit.trsf);
+        nodes.push_back(aNode);
+    }
+
+    readMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return !nodes.empty();
+}
+
+Bnd_Box AssemblyLoader::estimateBox(const Handle(Standard_Transient)& definition) const
+{
+    /*
+    * every entity reachable from the representation, including the
+    * representations linked to it without a transformation: points bound
+    * lines and splines, circles and spheres add their radius
+    */
+    Handle(StepShape_ShapeDefinitionRepresentation) sdr = Handle(StepShape_ShapeDefinitionRepresentation)::DownCast(definition);
+    const Interface_Graph& aGraph = stepReader.WS()->Graph();
+    Bnd_Box aBox;
+    TColStd_MapOfTransient visited;
+    vector<Handle(Standard_Transient)> stack{ sdr->UsedRepresentation() };
+    while (!stack.empty())
+    {
+        Handle(Standard_Transient) anEntity = stack.back();
+        stack.pop_back();
+        if (!visited.Add(anEntity))
+            continue;
+
+        if (Handle(StepGeom_CartesianPoint) pnt = Handle(StepGeom_CartesianPoint)::DownCast(anEntity))
+        {
+            aBox.Add(stepPoint(pnt, lengthFactor));
+            continue;
+        }
+        if (Handle(StepGeom_Circle) circ = Handle(StepGeom_Circle)::DownCast(anEntity))
+        {
+            Handle(StepGeom_Axis2Placement3d) ax = circ->Position().Axis2Placement3d();
+            if (!ax.IsNull())
+            {
+                Bnd_Box aCirc;
+                aCirc.Add(stepPoint(ax->Location(), lengthFactor));
+                aCirc.Enlarge(circ->Radius() * lengthFactor);
+                aBox.Add(aCirc);
+            }
+        }
+        else if (Handle(StepGeom_SphericalSurface) sph = Handle(StepGeom_SphericalSurface)::DownCast(anEntity))
+        {
+            Bnd_Box aSph;
+            aSph.Add(stepPoint(sph->Position()->Location(), lengthFactor));
+            aSph.Enlarge(sph->Radius() * lengthFactor);
+            aBox.Add(aSph);
+        }
+        else if (Handle(StepGeom_ToroidalSurface) tor = Handle(StepGeom_ToroidalSurface)::DownCast(anEntity))
+        {
+            Bnd_Box aTor;
+            aTor.Add(stepPoint(tor->Position()->Location(), lengthFactor));
+            aTor.Enlarge((tor->MajorRadius() + tor->MinorRadius()) * lengthFactor);
+            aBox.Add(aTor);
+        }
+        else if (Handle(StepRepr_Representation) rep = Handle(StepRepr_Representation)::DownCast(anEntity))
+        {
+            for (Interface_EntityIterator it = aGraph.Sharings(rep); it.More(); it.Next())
+            {
+                Handle(StepRepr_ShapeRepresentationRelationship) srr = Handle(StepRepr_ShapeRepresentationRelationship)::DownCast(it.Value());
+                if (srr.IsNull() || srr->IsKind(STANDARD_TYPE(StepRepr_RepresentationRelationshipWithTransformation)))
+                    continue;
+                stack.push_back(srr->Rep1() == rep ? srr->Rep2() : srr->Rep1());
+            }
+        }
+
+        for (Interface_EntityIterator it = aGraph.Shareds(anEntity); it.More(); it.Next())
+            stack.push_back(it.Value());
+    }
+    return aBox;
+}
+
+int AssemblyLoader::partCount() const
+{
+    return static_cast<int>(parts.size());
+}
+
+int AssemblyLoader::nodeCount() const
+{
+    return static_cast<int>(nodes.size());
+}
+
+const AssemblyPart& AssemblyLoader::part(int id) const
+{
+    return parts[id];
+}
+
+const AssemblyNode& AssemblyLoader::node(int id) const
+{
+    return nodes[id];
+}
+
+bool AssemblyLoader::isLoaded(int partId) const
+{
+    std::lock_guard<std::mutex> lock(stateLock);
+    return !parts[partId].shape.IsNull();
+}
+
+TopoDS_Shape AssemblyLoader::require(int partId)
+{
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        AssemblyPart& aPart = parts[partId];
+        aPart.lastUse = ++useClock;
+        if (!aPart.shape.IsNull())
+            return aPart.shape;
+    }
+
+    /* one transfer at a time, the STEP session is not reentrant */
+    std::lock_guard<std::mutex> transfer(transferLock);
+    {
+        std::lock_guard<std::mutex> lock(stateLock);
+        if (!parts[partId].shape.IsNull())
+            return parts[partId].shape;  //loaded by the call ahead of us
+    }
+
+    Tracer::Span transferSpan("transfer part", "load");
+    TopoDS_Shape shp;
+    if (stepReader.TransferEntity(parts[partId].definition) && stepReader.NbShapes() > 0)
+        shp = stepReader.Shape(stepReader.NbShapes());
+    transferSpan.close();
+
+    /* keep only our copy, the session would hold every part ever transferred */
+    stepReader.ClearShapes();
+    stepReader.WS()->TransferReader()->Clear(-1);
+    if (shp.IsNull())
+        return shp;
+
+    IMeshTools_Parameters meshParam;
+    meshParam.Deflection = StepLoader::meshDeflection(shp, deviationCoefficient);
+    meshParam.Angle = deviationAngle;
+    meshParam.InParallel = TaskScheduler::instance().hasIdleThreads();
+    Tracer::Span meshSpan("mesh part", "mesh");
+    BRepMesh_IncrementalMesh mesher(shp, meshParam);
+    meshSpan.close();
+
+    std::lock_guard<std::mutex> lock(stateLock);
+    AssemblyPart& aPart = parts[partId];
+    aPart.shape = shp;
+    aPart.bytes = shapeBytes(shp);
+    usedBytes += aPart.bytes;
+    return shp;
+}
+
+TopoDS_Shape AssemblyLoader::nodeShape(int nodeId) const
+{
+    std::lock_guard<std::mutex> lock(stateLock);
+    const AssemblyNode& aNode = nodes[nodeId];
+    const TopoDS_Shape& shp = parts[aNode.part].shape;
+    return shp.IsNull() ? shp : shp.Moved(TopLoc_Location(aNode.location));
+}
+
+void AssemblyLoader::setMemoryCap(size_t bytes)
+{
+    memoryCap = bytes;
+}
+
+size_t AssemblyLoader::memoryUsed() const
+{
+    std::lock_guard<std::mutex> lock(stateLock);
+    return usedBytes;
+}
+
+vector<int> AssemblyLoader::evict(const std::set<int>& pinned)
+{
+    std::lock_guard<std::mutex> lock(stateLock);
+    vector<int> evicted;
+    while (usedBytes > memoryCap)
+    {
+        int oldest = -1;
+        for (int i = 0; i < static_cast<int>(parts.size()); i++)
+        {
+            if (parts[i].shape.IsNull() || pinned.count(i) > 0)
+                continue;
+            if (oldest < 0 || parts[i].lastUse < parts[oldest].lastUse)
+                oldest = i;
+        }
+        if (oldest < 0)
+            break;  //everything left is pinned
+
+        parts[oldest].shape.Nullify();
+        usedBytes -= parts[oldest].bytes;
+        parts[oldest].bytes = 0;
+        evicted.push_back(oldest);
+    }
+    return evicted;
+}
+
+void AssemblyLoader::setDeviation(double coefficient, double angle)
+{
+    deviationCoefficient = coefficient;
+    deviationAngle = angle;
+}
+
+double AssemblyLoader::readTime() const
+{
+    return readMs;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <set>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <gp_Trsf.hxx>
+#include <Bnd_Box.hxx>
+#include <TopoDS_Shape.hxx>
+#include <Standard_Transient.hxx>
+#include <STEPControl_Reader.hxx>
+
+using std::vector;
+
+/* a leaf product, shared by all of its placed instances */
+struct AssemblyPart
+{
+	std::string name;
+	Handle(Standard_Transient) definition;  //StepShape_ShapeDefinitionRepresentation
+	Bnd_Box box;             //in part coordinates, estimated before transfer
+	TopoDS_Shape shape;      //null until required, null again once evicted
+	size_t bytes = 0;        //estimated shape and mesh memory
+	uint64_t lastUse = 0;
+};
+
+/* one placed instance of a part in the flattened product tree */
+struct AssemblyNode
+{
+	int part;
+	std::string path;        //product names from the root, '/' separated
+	gp_Trsf location;        //part coordinates to model coordinates
+	Bnd_Box box;             //in model coordinates
+};
+
+/*
+* AssemblyLoader opens a STEP assembly without transferring it. read()
+* parses the file and reads only the product structure: NAUO links,
+* instance placements and per-part boxes estimated from the cartesian
+* points and circle/sphere/torus radii of each representation.
+* Part geometry is transferred and meshed when required(), one part at a
+* time, and the least recently used parts are evicted above the memory cap.
+* require() may run on a worker, everything else is cheap and ui safe.
+*/
+class AssemblyLoader
+{
+public:
+	/* fileName is utf-8 */
+	explicit AssemblyLoader(const std::string& fileName);
+	~AssemblyLoader();
+
+	bool read();
+
+	int partCount() const;
+	int nodeCount() const;
+	const AssemblyPart& part(int id) const;
+	const AssemblyNode& node(int id) const;
+
+	bool isLoaded(int partId) const;
+	/* transfer and mesh a part if needed, returns its shape in part coordinates */
+	TopoDS_Shape require(int partId);
+	/* shape of an instance in model coordinates, null if its part is not loaded */
+	TopoDS_Shape nodeShape(int nodeId) const;
+
+	void setMemoryCap(size_t bytes);
+	size_t memoryUsed() const;
+	/* drop least recently used parts until under the cap, returns their ids */
+	vector<int> evict(const std::set<int>& pinned);
+
+	void setDeviation(double coefficient, double angle);
+	double readTime() const;
+
+private:
+	Bnd_Box estimateBox(const Handle(Standard_Transient)& definition) const;
+
+private:
+	std::string fileName;
+	STEPControl_Reader stepReader;
+	double lengthFactor;
+
+	vector<AssemblyPart> parts;
+	vector<AssemblyNode> nodes;
+
+	size_t memoryCap;
+	size_t usedBytes;
+	uint64_t useClock;
+	double deviationCoefficient;
+	double deviationAngle;
+	double readMs;
+
+	/* stateLock guards the part fields, transferLock the STEP session */
+	mutable std::mutex stateLock;
+	std::mutex transferLock;
+};
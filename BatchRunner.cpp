@@ -0,0 +1,404 @@
+#include "BatchRunner.h"
+#include "StepLoader.h"
+#include "ShapeWriter.h"
+#include "TopoIndex.h"
+#include "FaceTable.h"
+#include "Feature.h"
+#include "Obb.h"
+#include "OffscreenRenderer.h"
+#include "TaskScheduler.h"
+#include "Tracer.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <iostream>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QDirIterator>
+
+#include <BRep_Tool.hxx>
+#include <BRepCheck_Analyzer.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <IMeshTools_Parameters.hxx>
+#include <ShapeFix_Shape.hxx>
+#include <STEPControl_Controller.hxx>
+#include <Standard_Failure.hxx>
+#include <TopoDS.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopLoc_Location.hxx>
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(const Clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static int countTriangles(const TopoDS_Shape& shp)
+{
+    int count = 0;
+    for (TopExp_Explorer exp(shp, TopAbs_FACE); exp.More(); exp.Next())
+    {
+        TopLoc_Location aLoc;
+        Handle(Poly_Triangulation) triMesh = BRep_Tool::Triangulation(TopoDS::Face(exp.Current()), aLoc);
+        if (!triMesh.IsNull())
+            count += triMesh->NbTriangles();
+    }
+    return count;
+}
+
+static QJsonArray pointArray(const gp_XYZ& xyz)
+{
+    return QJsonArray{ xyz.X(), xyz.Y(), xyz.Z() };
+}
+
+BatchRunner::BatchRunner(const BatchJob& job) : batchJob(job)
+{
+
+}
+
+BatchRunner::~BatchRunner()
+{
+
+}
+
+bool BatchRunner::readJob(const QString& jobFile, BatchJob& job, QString& error)
+{
+    QFile file(jobFile);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = QString("can not open %1").arg(jobFile);
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject())
+    {
+        error = QString("%1: %2").arg(jobFile).arg(parseError.errorString());
+        return false;
+    }
+
+    /* relative paths are taken from the job file location */
+    QJsonObject obj = doc.object();
+    QDir base = QFileInfo(jobFile).absoluteDir();
+    QStringList filters{ "*.stp", "*.step" };
+    for (const QJsonValue& value : obj["input"].toArray())
+    {
+        QFileInfo info(base.absoluteFilePath(value.toString()));
+        if (info.isDir())
+        {
+            QDirIterator it(info.absoluteFilePath(), filters, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+                job.files << it.next();
+        }
+        else if (info.exists())
+        {
+            job.files << info.absoluteFilePath();
+        }
+        else
+        {
+            std::cerr << "skip missing input " << value.toString().toStdString() << std::endl;
+        }
+    }
+
+    for (const QJsonValue& value : obj["ops"].toArray())
+        job.ops << value.toString().toLower();
+    job.threads = obj["threads"].toInt(0);
+    job.outDir = base.absoluteFilePath(obj["output"].toString("."));
+    job.format = obj["format"].toString(job.format);
+    job.deviation = obj["deviation"].toDouble(job.deviation);
+    job.useCache = obj["cache"].toBool(job.useCache);
+    QJsonArray thumbSize = obj["thumbnail"].toArray();
+    if (thumbSize.size() == 2)
+    {
+        job.thumbWidth = thumbSize[0].toInt(job.thumbWidth);
+        job.thumbHeight = thumbSize[1].toInt(job.thumbHeight);
+    }
+    job.frames = obj["frames"].toInt(0);
+    if (obj.contains("reference"))
+        job.referenceDir = base.absoluteFilePath(obj["reference"].toString());
+    if (obj.contains("trace"))
+        job.traceFile = QDir(job.outDir).absoluteFilePath(obj["trace"].toString());
+    if (obj.contains("generate"))
+    {
+        job.isGenerating = true;
+        job.generator = GeneratorOptions::fromJson(obj["generate"].toObject());
+    }
+
+    if (job.files.isEmpty() && !job.isGenerating)
+    {
+        error = QString("%1: no input files").arg(jobFile);
+        return false;
+    }
+    return true;
+}
+
+int BatchRunner::run()
+{
+    QDir().mkpath(batchJob.outDir);
+    QString error;
+    if (batchJob.isGenerating && !generate(error))
+    {
+        /* reported as a failed file, nothing else runs */
+        BatchResult result;
+        result.file = "generate";
+        result.error = error;
+        batchResults.assign(1, result);
+        std::cerr << error.toStdString() << std::endl;
+        return 1;
+    }
+    batchResults.assign(batchJob.files.size(), BatchResult());
+
+    /* the STEP controller registers static parameters, once before the workers */
+    STEPControl_Controller::Init();
+    if (batchJob.ops.contains("thumbnail"))
+        OffscreenRenderer::initThreads();
+
+    /* a file is a task of the shared scheduler, the analysis inside it nests without extra threads */
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    if (batchJob.threads > 0)
+        scheduler.setThreadCount(batchJob.threads);
+
+    std::atomic<int> done(0);
+    std::mutex printLock;
+    scheduler.parallelFor(0, static_cast<int>(batchJob.files.size()), [&](int i)
+    {
+        batchResults[i] = process(batchJob.files[i]);
+        const BatchResult& result = batchResults[i];
+        std::lock_guard<std::mutex> lock(printLock);
+        std::cout << "[" << ++done << "/" << batchJob.files.size() << "] "
+            << result.file.toStdString() << (result.isDone ? " done " : " failed ")
+            << result.elapsed << " ms" << std::endl;
+    }, TaskPriority::Background);
+
+    int nbFailed = 0;
+    for (const BatchResult& result : batchResults)
+        nbFailed += result.isDone ? 0 : 1;
+    return nbFailed;
+}
+
+bool BatchRunner::generate(QString& error)
+{
+    /* STEP, so the model goes through the same load as the input files */
+    ModelGenerator generator(batchJob.generator);
+    QDir outDir(batchJob.outDir);
+    QString modelFile = outDir.absoluteFilePath(QString("generated-%1.stp").arg(batchJob.generator.seed));
+    if (!ShapeWriter(modelFile.toLocal8Bit().data(), generator.assembly()).write())
+    {
+        error = QString("can not write %1").arg(modelFile);
+        return false;
+    }
+    batchJob.files.prepend(modelFile);
+
+    if (batchJob.generator.triangles > 0)
+    {
+        QString soupFile = outDir.absoluteFilePath(QString("soup-%1.bbrep").arg(batchJob.generator.seed));
+        TopoDS_Shape aSoup = ModelGenerator::soupShape(generator.triangleSoup(batchJob.generator.triangles, 20.0));
+        if (!ShapeWriter(soupFile.toLocal8Bit().data(), aSoup).write())
+        {
+            error = QString("can not write %1").arg(soupFile);
+            return false;
+        }
+    }
+    std::cout << "generated " << batchJob.generator.parts << " parts, seed " << batchJob.generator.seed << std::endl;
+    return true;
+}
+
+BatchResult BatchRunner::process(const QString& file) const
+{
+    BatchResult result;
+    result.file = file;
+    Clock::time_point start = Clock::now();
+    Tracer::Span span("file", "batch");
+
+    try
+    {
+        /* load is implied, every other op works on the loaded shape */
+        StepLoader loader(file.toUtf8().data());
+        loader.setMeshing(false);
+        loader.setCache(batchJob.useCache);
+        if (!loader.load())
+        {
+            result.error = QString("load failed, read status %1").arg(loader.status());
+            result.elapsed = elapsedMs(start);
+            return result;
+        }
+        TopoDS_Shape shp = loader.shape();
+        result.info["load"] = QJsonObject{ { "shapes", loader.shapeCount() },
+            { "ms", loader.timings().total() }, { "cached", loader.isFromCache() } };
+
+        for (const QString& op : batchJob.ops)
+        {
+            Clock::time_point opStart = Clock::now();
+            QJsonObject info;
+            if (op == "load")
+            {
+                continue;
+            }
+            else if (op == "heal")
+            {
+                bool wasValid = BRepCheck_Analyzer(shp).IsValid();
+                ShapeFix_Shape fixer(shp);
+                fixer.Perform();
+                shp = fixer.Shape();
+                info["validBefore"] = wasValid;
+                info["validAfter"] = static_cast<bool>(BRepCheck_Analyzer(shp).IsValid());
+            }
+            else if (op == "mesh")
+            {
+                IMeshTools_Parameters meshParam;
+                meshParam.Deflection = StepLoader::meshDeflection(shp, batchJob.deviation);
+                meshParam.Angle = 20.0 * M_PI / 180.0;
+                meshParam.InParallel = TaskScheduler::instance().hasIdleThreads();
+                BRepMesh_IncrementalMesh mesher(shp, meshParam);
+                info["deflection"] = meshParam.Deflection;
+                info["triangles"] = countTriangles(shp);
+            }
+            else if (op == "obb")
+            {
+                Obb obb(shp);
+                info["center"] = pointArray(obb.obbShape.Center());
+                info["halfSize"] = QJsonArray{ obb.obbShape.XHSize(), obb.obbShape.YHSize(), obb.obbShape.ZHSize() };
+                info["faces"] = static_cast<int>(obb.obbList.size());
+            }
+            else if (op == "analysis")
+            {
+                TopoIndex index(shp);
+                FaceTable table(index);
+                vector<Feature> features = FeatureRecognizer(index, table).recognize();
+                info["solids"] = index.solidCount();
+                info["faces"] = index.faceCount();
+                info["edges"] = index.edgeCount();
+                QJsonObject counts;
+                for (const Feature& feature : features)
+                {
+                    QString name = FeatureRecognizer::typeName(feature.type);
+                    counts[name] = counts[name].toInt() + 1;
+                }
+                info["features"] = counts;
+            }
+            else if (op == "thumbnail")
+            {
+                /* one renderer per worker thread, its GL context can not move */
+                thread_local std::unique_ptr<OffscreenRenderer> renderer;
+                if (!renderer)
+                {
+                    RenderOptions options;
+                    options.width = batchJob.thumbWidth;
+                    options.height = batchJob.thumbHeight;
+                    renderer.reset(new OffscreenRenderer(options));
+                }
+                if (!renderer->isValid())
+                {
+                    result.error = QString("no offscreen renderer: %1").arg(renderer->error().c_str());
+                    break;
+                }
+
+                QString outFile = QDir(batchJob.outDir).absoluteFilePath(QFileInfo(file).completeBaseName() + ".png");
+                renderer->clear();
+                renderer->add(shp);
+                if (!renderer->dump(outFile.toLocal8Bit().data()))
+                {
+                    result.error = QString("thumbnail failed: %1").arg(renderer->error().c_str());
+                    break;
+                }
+                info["file"] = outFile;
+                info["renderMs"] = renderer->renderTime();
+                if (batchJob.frames > 0)
+                    info["frameMs"] = renderer->frameTime(batchJob.frames);
+                if (!batchJob.referenceDir.isEmpty())
+                {
+                    QString reference = QDir(batchJob.referenceDir).absoluteFilePath(QFileInfo(outFile).fileName());
+                    info["diffPixels"] = OffscreenRenderer::compare(outFile.toLocal8Bit().data(),
+                        reference.toLocal8Bit().data(), 0.1);
+                }
+                renderer->clear();
+            }
+            else if (op == "export")
+            {
+                QString outFile = QDir(batchJob.outDir).absoluteFilePath(
+                    QFileInfo(file).completeBaseName() + "." + batchJob.format);
+                ShapeWriter writer(outFile.toLocal8Bit().data(), shp);
+                if (!writer.write())
+                {
+                    result.error = QString("export to %1 failed").arg(outFile);
+                    break;
+                }
+                info["file"] = outFile;
+            }
+            else
+            {
+                result.error = QString("unknown op %1").arg(op);
+                break;
+            }
+            info["ms"] = elapsedMs(opStart);
+            result.info[op] = info;
+        }
+        result.isDone = result.error.isEmpty();
+    }
+    catch (const Standard_Failure& failure)
+    {
+        result.error = failure.GetMessageString();
+    }
+    catch (const std::exception& e)
+    {
+        result.error = e.what();
+    }
+
+    result.elapsed = elapsedMs(start);
+    return result;
+}
+
+const vector<BatchResult>& BatchRunner::results() const
+{
+    return batchResults;
+}
+
+QJsonDocument BatchRunner::report() const
+{
+    QJsonArray files;
+    for (const BatchResult& result : batchResults)
+    {
+        QJsonObject obj = result.info;
+        obj["file"] = result.file;
+        obj["done"] = result.isDone;
+        obj["ms"] = result.elapsed;
+        if (!result.error.isEmpty())
+            obj["error"] = result.error;
+        files.append(obj);
+    }
+    return QJsonDocument(QJsonObject{ { "files", files } });
+}
+
+int BatchRunner::exec(const QString& jobFile)
+{
+    BatchJob job;
+    QString error;
+    if (!readJob(jobFile, job, error))
+    {
+        std::cerr << error.toStdString() << std::endl;
+        return 2;
+    }
+
+    Clock::time_point start = Clock::now();
+    Tracer::setThreadName("main");
+    Tracer::setEnabled(Tracer::isEnabled() || !job.traceFile.isEmpty());
+    BatchRunner runner(job);
+    int nbFailed = runner.run();
+    if (!job.traceFile.isEmpty() && !Tracer::write(job.traceFile.toLocal8Bit().data()))
+        std::cerr << "can not write " << job.traceFile.toStdString() << std::endl;
+
+    QFile reportFile(QDir(job.outDir).absoluteFilePath("report.json"));
+    if (reportFile.open(QIODevice::WriteOnly))
+        reportFile.write(runner.report().toJson());
+
+    std::cout << runner.results().size() - nbFailed << " done, " << nbFailed << " failed in "
+        << elapsedMs(start) << " ms" << std::endl;
+    return nbFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include "ModelGenerator.h"
+
+using std::vector;
+
+/*
+* job description, read from json:
+* {
+*   "input":     ["part.stp", "models/"],  files, or directories scanned for *.stp *.step
+*   "ops":       ["load", "heal", "mesh", "obb", "analysis", "export"],
+*   "threads":   8,                        0 or missing: one per core
+*   "output":    "out/",                   exported files and report.json
+*   "format":    "bbrep",                  export suffix: stp, brep or bbrep
+*   "deviation": 0.001,                    mesh deviation coefficient
+*   "cache":     true,                     use the import cache on load
+*   "thumbnail": [256, 256],               image size of the thumbnail op
+*   "frames":    0,                        thumbnail op: also time this many redraws
+*   "reference": "ref/"                    thumbnail op: compare with the images there
+*   "trace":     "trace.json",             Chrome trace of the whole run, in the output directory
+*   "generate":  { "seed": 1, ... }        write a ModelGenerator model and its triangle soup
+*                                          to the output directory and process the model too
+* }
+*/
+struct BatchJob
+{
+	QStringList files;
+	QStringList ops;
+	int threads = 0;
+	QString outDir;
+	QString format = "bbrep";
+	double deviation = 0.001;
+	bool useCache = false;
+	int thumbWidth = 256;
+	int thumbHeight = 256;
+	int frames = 0;
+	QString referenceDir;
+	QString traceFile;
+	bool isGenerating = false;
+	GeneratorOptions generator;
+};
+
+struct BatchResult
+{
+	QString file;
+	bool isDone = false;
+	QString error;
+	QJsonObject info;     //per operation results and timings
+	double elapsed = 0.0;
+};
+
+/*
+* BatchRunner processes the files of a job as background tasks of the
+* TaskScheduler, one file per task. Nothing here touches QccView; only the
+* thumbnail op needs a display, through an OffscreenRenderer per worker.
+*/
+class BatchRunner
+{
+public:
+	explicit BatchRunner(const BatchJob& job);
+	~BatchRunner();
+
+	static bool readJob(const QString& jobFile, BatchJob& job, QString& error);
+
+	/* `Qcc --batch job.json`, returns the process exit code */
+	static int exec(const QString& jobFile);
+
+	/* number of failed files */
+	int run();
+	const vector<BatchResult>& results() const;
+	QJsonDocument report() const;
+
+private:
+	BatchResult process(const QString& file) const;
+	/* writes the generated model, its file joins the job files */
+	bool generate(QString& error);
+
+private:
+	BatchJob batchJob;
+	vector<BatchResult> batchResults;
+};
@@ -0,0 +1,188 @@
+#include "Document.h"
+#include "ShapeInstancer.h"
+#include <algorithm>
+
+#include <AIS_Shape.hxx>
+#include <AIS_ConnectedInteractive.hxx>
+#include <BRepGProp.hxx>
+#include <GProp_GProps.hxx>
+#include <TopLoc_Location.hxx>
+
+std::shared_ptr<ShapeProperties> ShapeProperties::compute(const TopoDS_Shape& shp)
+{
+    std::shared_ptr<ShapeProperties> props = std::make_shared<ShapeProperties>();
+    props->shape = shp;
+    GProp_GProps aVolume, aSurface;
+    BRepGProp::VolumeProperties(shp, aVolume);
+    BRepGProp::SurfaceProperties(shp, aSurface);
+    props->volume = aVolume.Mass();
+    props->area = aSurface.Mass();
+    props->centre = aVolume.Mass() > 0.0 ? aVolume.CentreOfMass() : aSurface.CentreOfMass();
+    return props;
+}
+
+TopoDS_Shape DocObject::located() const
+{
+    return shape.Moved(TopLoc_Location(pose));
+}
+
+void DocObject::markDirty()
+{
+    revision++;
+    topology.isDirty = true;
+    faces.isDirty = true;
+    features.isDirty = true;
+    mesh.isDirty = true;
+    obb.isDirty = true;
+    properties.isDirty = true;
+}
+
+Document::Document() : nextId(1), activeId(NoObject)
+{
+
+}
+
+Document::~Document()
+{
+
+}
+
+ObjectId Document::add(const TopoDS_Shape& shp, const gp_Trsf& pose)
+{
+    DocObject& anObject = objects[nextId];
+    anObject.id = nextId;
+    anObject.shape = shp;
+    anObject.pose = pose;
+    return nextId++;
+}
+
+void Document::remove(ObjectId id)
+{
+    auto it = objects.find(id);
+    if (it == objects.end())
+        return;
+    for (const Handle(AIS_InteractiveObject)& obj : it->second.presentations)
+        presented.erase(obj.get());
+    objects.erase(it);
+    if (activeId == id)
+        activeId = NoObject;
+}
+
+void Document::clear()
+{
+    objects.clear();
+    presented.clear();
+    selected.clear();
+    activeId = NoObject;
+}
+
+DocObject* Document::object(ObjectId id)
+{
+    auto it = objects.find(id);
+    return it == objects.end() ? nullptr : &it->second;
+}
+
+const DocObject* Document::object(ObjectId id) const
+{
+    auto it = objects.find(id);
+    return it == objects.end() ? nullptr : &it->second;
+}
+
+vector<ObjectId> Document::ids() const
+{
+    vector<ObjectId> ret;
+    ret.reserve(objects.size());
+    for (const auto& item : objects)
+        ret.push_back(item.first);
+    return ret;
+}
+
+void Document::bind(ObjectId id, const Handle(AIS_InteractiveObject)& obj)
+{
+    if (obj.IsNull() || objectOf(obj) == id)
+        return;
+    /* unbind first, it may remove the object the presentation had */
+    unbind(obj);
+    DocObject* anObject = object(id);
+    if (!anObject)
+        return;
+    anObject->presentations.push_back(obj);
+    presented[obj.get()] = id;
+}
+
+void Document::unbind(const Handle(AIS_InteractiveObject)& obj)
+{
+    auto it = presented.find(obj.get());
+    if (it == presented.end())
+        return;
+
+    /* an object without presentations is gone from the scene */
+    ObjectId id = it->second;
+    presented.erase(it);
+    DocObject* anObject = object(id);
+    if (!anObject)
+        return;
+    vector<Handle(AIS_InteractiveObject)>& list = anObject->presentations;
+    list.erase(std::remove(list.begin(), list.end(), obj), list.end());
+    if (list.empty())
+        remove(id);
+}
+
+ObjectId Document::objectOf(const Handle(AIS_InteractiveObject)& obj) const
+{
+    auto it = presented.find(obj.get());
+    return it == presented.end() ? NoObject : it->second;
+}
+
+ObjectId Document::acquire(const Handle(AIS_InteractiveObject)& obj)
+{
+    ObjectId id = objectOf(obj);
+    if (id != NoObject || obj.IsNull())
+        return id;
+
+    /* the shape of the AIS_Shape or of the reference, the pose of the presentation */
+    TopoDS_Shape aShape = ShapeInstancer::shapeOf(obj);
+    if (aShape.IsNull())
+        return NoObject;
+    gp_Trsf aPose = obj->LocalTransformation();
+    id = add(aShape.Moved(TopLoc_Location(aPose.Inverted())), aPose);
+    bind(id, obj);
+    return id;
+}
+
+void Document::setShape(ObjectId id, const TopoDS_Shape& shp)
+{
+    DocObject* anObject = object(id);
+    if (!anObject)
+        return;
+    anObject->shape = shp;
+    anObject->markDirty();
+}
+
+void Document::setPose(ObjectId id, const gp_Trsf& pose)
+{
+    DocObject* anObject = object(id);
+    if (!anObject)
+        return;
+    anObject->pose = pose;
+}
+
+void Document::setActive(ObjectId id)
+{
+    activeId = object(id) ? id : NoObject;
+}
+
+ObjectId Document::active() const
+{
+    return activeId;
+}
+
+void Document::setSelection(const vector<TopoDS_Shape>& shapes)
+{
+    selected = shapes;
+}
+
+const vector<TopoDS_Shape>& Document::selection() const
+{
+    return selected;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <gp_Pnt.hxx>
+#include <gp_Trsf.hxx>
+#include <TopoDS_Shape.hxx>
+#include <AIS_InteractiveObject.hxx>
+#include "TopoIndex.h"
+#include "FaceTable.h"
+#include "Feature.h"
+
+using std::vector;
+
+class Mesh;
+class Obb;
+
+/* ids are never reused within a document, 0 is no object */
+typedef unsigned int ObjectId;
+const ObjectId NoObject = 0;
+
+struct ShapeProperties
+{
+	TopoDS_Shape shape;  //computed for
+	double volume = 0.0;
+	double area = 0.0;
+	gp_Pnt centre;
+
+	static std::shared_ptr<ShapeProperties> compute(const TopoDS_Shape& shp);
+};
+
+/*
+* derived data of an object, computed from one revision of its shape in the
+* object's own frame, so moving the object keeps it. A new shape marks it
+* dirty; the value stays readable until a job computes the new one.
+*/
+template <typename T>
+struct Artifact
+{
+	std::shared_ptr<T> value;
+	unsigned int revision = 0;
+	bool isDirty = true;
+
+	bool isValid() const { return value && !isDirty; }
+};
+
+struct DocObject
+{
+	ObjectId id = NoObject;
+	TopoDS_Shape shape;      //without the pose, what the artifacts are computed from
+	gp_Trsf pose;
+	unsigned int revision = 1;  //bumped by every change of the shape
+	vector<Handle(AIS_InteractiveObject)> presentations;
+
+	Artifact<TopoIndex> topology;
+	Artifact<FaceTable> faces;
+	Artifact<vector<Feature>> features;
+	Artifact<Mesh> mesh;
+	Artifact<Obb> obb;
+	Artifact<ShapeProperties> properties;
+
+	/* the shape where it is shown */
+	TopoDS_Shape located() const;
+	void markDirty();
+};
+
+/*
+* Document owns the objects of the session and everything derived from
+* them. It lives on the ui thread: a job copies the shape and its revision,
+* computes on a worker and attaches its result back here, where a result
+* for an older revision or a removed object is dropped.
+*/
+class Document
+{
+public:
+	Document();
+	~Document();
+
+	ObjectId add(const TopoDS_Shape& shp, const gp_Trsf& pose = gp_Trsf());
+	void remove(ObjectId id);
+	void clear();
+
+	DocObject* object(ObjectId id);
+	const DocObject* object(ObjectId id) const;
+	vector<ObjectId> ids() const;
+
+	/* a presentation shows a part of one object, an object may have many */
+	void bind(ObjectId id, const Handle(AIS_InteractiveObject)& obj);
+	void unbind(const Handle(AIS_InteractiveObject)& obj);
+	ObjectId objectOf(const Handle(AIS_InteractiveObject)& obj) const;
+	/* objectOf, registering an AIS_Shape or an instance made outside the document */
+	ObjectId acquire(const Handle(AIS_InteractiveObject)& obj);
+
+	void setShape(ObjectId id, const TopoDS_Shape& shp);
+	/* a new pose keeps the artifacts, they are shown with it */
+	void setPose(ObjectId id, const gp_Trsf& pose);
+
+	/* false when the object is gone or has changed since the job started */
+	template <typename T>
+	bool attach(ObjectId id, unsigned int revision, Artifact<T> DocObject::* slot, const std::shared_ptr<T>& value)
+	{
+		DocObject* anObject = object(id);
+		if (!anObject || anObject->revision != revision || !value)
+			return false;
+		Artifact<T>& anArtifact = anObject->*slot;
+		anArtifact.value = value;
+		anArtifact.revision = revision;
+		anArtifact.isDirty = false;
+		return true;
+	}
+
+	/* the object the analysis works on */
+	void setActive(ObjectId id);
+	ObjectId active() const;
+
+	/* picked sub-shapes, located */
+	void setSelection(const vector<TopoDS_Shape>& shapes);
+	const vector<TopoDS_Shape>& selection() const;
+
+private:
+	ObjectId nextId;
+	ObjectId activeId;
+	std::map<ObjectId, DocObject> objects;
+	std::map<const AIS_InteractiveObject*, ObjectId> presented;  //the handles are kept in DocObject
+	vector<TopoDS_Shape> selected;
+};
@@ -0,0 +1,205 @@
+#include "FaceTable.h"
+#include "TaskScheduler.h"
+#include "Tracer.h"
+#include <cmath>
+
+#include <BRepAdaptor_Surface.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepGProp.hxx>
+#include <BRepTools.hxx>
+#include <GProp_GProps.hxx>
+
+FaceTable::FaceTable()
+{
+
+}
+
+FaceTable::FaceTable(const TopoIndex& index, const CancelToken& token)
+{
+    Tracer::Span span("face table", "analysis");
+    build(index, token);
+}
+
+FaceTable::~FaceTable()
+{
+
+}
+
+void FaceTable::build(const TopoIndex& index, const CancelToken& token)
+{
+    topoShape = index.shape();
+    const int nbFaces = index.faceCount();
+    type.assign(nbFaces, GeomAbs_OtherSurface);
+    location.assign(nbFaces, gp_Pnt());
+    direction.assign(nbFaces, gp_Dir(0.0, 0.0, 1.0));
+    radius.assign(nbFaces, 0.0);
+    radius2.assign(nbFaces, 0.0);
+    area.assign(nbFaces, 0.0);
+    uMin.assign(nbFaces, 0.0);
+    uMax.assign(nbFaces, 0.0);
+    vMin.assign(nbFaces, 0.0);
+    vMax.assign(nbFaces, 0.0);
+    box.assign(nbFaces, Bnd_Box());
+    reversed.assign(nbFaces, 0);
+
+    /* each row is written by one task only, no locking needed */
+    TaskScheduler::instance().parallelFor(0, nbFaces, [&](int i)
+    {
+        const TopoDS_Face& face = index.face(i);
+        BRepAdaptor_Surface aSurf(face, Standard_False);
+        type[i] = aSurf.GetType();
+        reversed[i] = face.Orientation() == TopAbs_REVERSED;
+
+        switch (type[i])
+        {
+        case GeomAbs_Plane:
+        {
+            gp_Pln pln = aSurf.Plane();
+            location[i] = pln.Location();
+            direction[i] = reversed[i] ? pln.Axis().Direction().Reversed() : pln.Axis().Direction();
+            break;
+        }
+        case GeomAbs_Cylinder:
+        {
+            gp_Cylinder cyl = aSurf.Cylinder();
+            location[i] = cyl.Location();
+            direction[i] = cyl.Axis().Direction();
+            radius[i] = cyl.Radius();
+            break;
+        }
+        case GeomAbs_Cone:
+        {
+            gp_Cone cone = aSurf.Cone();
+            location[i] = cone.Location();
+            direction[i] = cone.Axis().Direction();
+            radius[i] = cone.RefRadius();
+            radius2[i] = cone.SemiAngle();
+            break;
+        }
+        case GeomAbs_Sphere:
+        {
+            gp_Sphere sph = aSurf.Sphere();
+            location[i] = sph.Location();
+            direction[i] = sph.Position().Direction();
+            radius[i] = sph.Radius();
+            break;
+        }
+        case GeomAbs_Torus:
+        {
+            gp_Torus tor = aSurf.Torus();
+            location[i] = tor.Location();
+            direction[i] = tor.Axis().Direction();
+            radius[i] = tor.MajorRadius();
+            radius2[i] = tor.MinorRadius();
+            break;
+        }
+        default:
+            break;
+        }
+
+        GProp_GProps props;
+        BRepGProp::SurfaceProperties(face, props);
+        area[i] = props.Mass();
+
+        BRepTools::UVBounds(face, uMin[i], uMax[i], vMin[i], vMax[i]);
+        BRepBndLib::Add(face, box[i], Standard_False);
+    }, TaskPriority::Normal, token);
+}
+
+int FaceTable::size() const
+{
+    return static_cast<int>(type.size());
+}
+
+const TopoDS_Shape& FaceTable::shape() const
+{
+    return topoShape;
+}
+
+vector<int> FaceTable::filter(const std::function<bool(int)>& pred) const
+{
+    vector<int> rows;
+    for (int i = 0; i < size(); i++)
+    {
+        if (pred(i))
+            rows.push_back(i);
+    }
+    return rows;
+}
+
+vector<int> FaceTable::selectType(GeomAbs_SurfaceType surfType) const
+{
+    return filter([&](int i) { return type[i] == surfType; });
+}
+
+vector<int> FaceTable::selectCylinders(double r, double tol) const
+{
+    return filter([&](int i) {
+        return type[i] == GeomAbs_Cylinder && std::abs(radius[i] - r) <= tol;
+    });
+}
+
+vector<int> FaceTable::selectSimilar(int row, double tol) const
+{
+    return filter([&](int i) {
+        return type[i] == type[row]
+            && std::abs(radius[i] - radius[row]) <= tol
+            && std::abs(radius2[i] - radius2[row]) <= tol;
+    });
+}
+
+vector<int> FaceTable::typeHistogram() const
+{
+    vector<int> bins(GeomAbs_OtherSurface + 1, 0);
+    for (GeomAbs_SurfaceType t : type)
+        bins[t]++;
+    return bins;
+}
+
+vector<int> FaceTable::histogram(const vector<double>& column, double lo, double hi, int bins,
+    const vector<int>& rows) const
+{
+    vector<int> counts(bins > 0 ? bins : 0, 0);
+    if (bins <= 0 || hi <= lo)
+        return counts;
+
+    const double width = (hi - lo) / bins;
+    auto add = [&](int i)
+    {
+        double v = column[i];
+        if (v < lo || v >= hi)
+            return;
+        int b = static_cast<int>((v - lo) / width);
+        counts[b < bins ? b : bins - 1]++;
+    };
+
+    if (rows.empty())
+    {
+        for (int i = 0; i < static_cast<int>(column.size()); i++)
+            add(i);
+    }
+    else
+    {
+        for (int i : rows)
+            add(i);
+    }
+    return counts;
+}
+
+const char* FaceTable::typeName(GeomAbs_SurfaceType surfType)
+{
+    switch (surfType)
+    {
+    case GeomAbs_Plane:               return "GeomAbs_Plane";
+    case GeomAbs_Cylinder:            return "GeomAbs_Cylinder";
+    case GeomAbs_Cone:                return "GeomAbs_Cone";
+    case GeomAbs_Sphere:              return "GeomAbs_Sphere";
+    case GeomAbs_Torus:               return "GeomAbs_Torus";
+    case GeomAbs_BezierSurface:       return "GeomAbs_BezierSurface";
+    case GeomAbs_BSplineSurface:      return "GeomAbs_BSplineSurface";
+    case GeomAbs_SurfaceOfRevolution: return "GeomAbs_SurfaceOfRevolution";
+    case GeomAbs_SurfaceOfExtrusion:  return "GeomAbs_SurfaceOfExtrusion";
+    case GeomAbs_OffsetSurface:       return "GeomAbs_OffsetSurface";
+    default:                          return "GeomAbs_OtherSurface";
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "TopoIndex.h"
+#include "TaskScheduler.h"
+#include <vector>
+#include <functional>
+#include <GeomAbs_SurfaceType.hxx>
+#include <Bnd_Box.hxx>
+#include <gp_Pnt.hxx>
+#include <gp_Dir.hxx>
+
+using std::vector;
+
+/*
+* FaceTable classifies every face of a TopoIndex in parallel and keeps
+* the results column by column, row i is face id i of the index.
+* Analytic parameters by surface type:
+*   plane    location = origin, direction = normal along the face orientation
+*   cylinder location/direction = axis, radius
+*   cone     location/direction = axis, radius = ref radius, radius2 = semi-angle
+*   sphere   location = center, radius
+*   torus    location/direction = axis, radius = major, radius2 = minor
+*/
+class FaceTable
+{
+public:
+	FaceTable();
+	/* a cancelled token leaves the remaining rows unclassified */
+	explicit FaceTable(const TopoIndex& index, const CancelToken& token = CancelToken());
+	~FaceTable();
+
+	void build(const TopoIndex& index, const CancelToken& token = CancelToken());
+	int size() const;
+	const TopoDS_Shape& shape() const;
+
+	/* rows where pred(row) is true */
+	vector<int> filter(const std::function<bool(int)>& pred) const;
+	vector<int> selectType(GeomAbs_SurfaceType surfType) const;
+	vector<int> selectCylinders(double radius, double tol = 1e-3) const;
+	vector<int> selectSimilar(int row, double tol = 1e-3) const;
+
+	/* face count per GeomAbs_SurfaceType, indexed by the enum value */
+	vector<int> typeHistogram() const;
+	/* bins over [lo, hi) of a double column, all rows if rows is empty */
+	vector<int> histogram(const vector<double>& column, double lo, double hi, int bins,
+		const vector<int>& rows = vector<int>()) const;
+
+	static const char* typeName(GeomAbs_SurfaceType surfType);
+
+public:
+	vector<GeomAbs_SurfaceType> type;
+	vector<gp_Pnt> location;
+	vector<gp_Dir> direction;
+	vector<double> radius;
+	vector<double> radius2;
+	vector<double> area;
+	vector<double> uMin;
+	vector<double> uMax;
+	vector<double> vMin;
+	vector<double> vMax;
+	vector<Bnd_Box> box;
+	vector<char> reversed;  //face orientation is TopAbs_REVERSED
+
+private:
+	TopoDS_Shape topoShape;
+};
@@ -0,0 +1,396 @@
+#include "Feature.h"
+#include "TaskScheduler.h"
+#include "Tracer.h"
+#include "Arena.h"
+#include <algorithm>
+#include <cmath>
+
+#include <TopoDS.hxx>
+#include <TopExp_Explorer.hxx>
+#include <BRep_Tool.hxx>
+#include <BRepAdaptor_Curve.hxx>
+#include <BRepAdaptor_Curve2d.hxx>
+#include <BRepAdaptor_Surface.hxx>
+#include <GCPnts_AbscissaPoint.hxx>
+#include <gp_Lin.hxx>
+#include <ElCLib.hxx>
+
+/* oriented normal of the face at the point of the edge at param */
+static gp_Vec edgeFaceNormal(const TopoDS_Edge& edge, const TopoDS_Face& face, double param)
+{
+    BRepAdaptor_Curve2d pcurve(edge, face);
+    gp_Pnt2d uv = pcurve.Value(param);
+
+    BRepAdaptor_Surface aSurf(face, Standard_False);
+    gp_Pnt pnt;
+    gp_Vec du, dv;
+    aSurf.D1(uv.X(), uv.Y(), pnt, du, dv);
+    gp_Vec normal = du.Crossed(dv);
+    if (normal.Magnitude() > gp::Resolution())
+        normal.Normalize();
+    return face.Orientation() == TopAbs_REVERSED ? normal.Reversed() : normal;
+}
+
+FeatureRecognizer::FeatureRecognizer(const TopoIndex& index, const FaceTable& table)
+    : topoIndex(index), faceTable(table), angTol(M_PI / 180.0), linTol(1.0e-3)
+{
+
+}
+
+FeatureRecognizer::~FeatureRecognizer()
+{
+
+}
+
+const char* FeatureRecognizer::typeName(FeatureType type)
+{
+    switch (type)
+    {
+    case FeatureType::Hole:    return "Hole";
+    case FeatureType::Boss:    return "Boss";
+    case FeatureType::Fillet:  return "Fillet";
+    case FeatureType::Chamfer: return "Chamfer";
+    }
+    return "";
+}
+
+Convexity FeatureRecognizer::edgeConvexity(int edgeId) const
+{
+    return convexity[edgeId];
+}
+
+double FeatureRecognizer::edgeLength(int edgeId) const
+{
+    return length[edgeId];
+}
+
+void FeatureRecognizer::computeEdges(const CancelToken& token)
+{
+    const int nbEdges = topoIndex.edgeCount();
+    convexity.assign(nbEdges, Convexity::Boundary);
+    length.assign(nbEdges, 0.0);
+
+    TaskScheduler::instance().parallelFor(0, nbEdges, [&](int e)
+    {
+        const TopoDS_Edge& edge = topoIndex.edge(e);
+        if (BRep_Tool::Degenerated(edge))
+            return;
+
+        BRepAdaptor_Curve curve(edge);
+        length[e] = GCPnts_AbscissaPoint::Length(curve);
+
+        TopoRange faces = topoIndex.edgeFaces(e);
+        if (faces.size() != 2)
+            return;
+
+        /* the edge as oriented in the first face, a seam shows up twice */
+        const TopoDS_Face& face1 = topoIndex.face(faces[0]);
+        const TopoDS_Face& face2 = topoIndex.face(faces[1]);
+        int found = 0;
+        TopAbs_Orientation edgeOri = TopAbs_FORWARD;
+        for (TopExp_Explorer exp(face1, TopAbs_EDGE); exp.More(); exp.Next())
+        {
+            if (exp.Current().IsSame(edge))
+            {
+                edgeOri = exp.Current().Orientation();
+                found++;
+            }
+        }
+        if (found != 1)
+            return;
+
+        double mid = (curve.FirstParameter() + curve.LastParameter()) / 2.0;
+        gp_Pnt pnt;
+        gp_Vec tangent;
+        curve.D1(mid, pnt, tangent);
+        if (edgeOri == TopAbs_REVERSED)
+            tangent.Reverse();
+
+        /*
+        * the matter of face1 is on the left of its oriented edges, so the
+        * edge is convex when (n1 x n2) goes along the edge tangent
+        */
+        gp_Vec n1 = edgeFaceNormal(edge, face1, mid);
+        gp_Vec n2 = edgeFaceNormal(edge, face2, mid);
+        gp_Vec cross = n1.Crossed(n2);
+        if (cross.Magnitude() < std::sin(angTol))
+            convexity[e] = Convexity::Smooth;
+        else
+            convexity[e] = cross.Dot(tangent) > 0.0 ? Convexity::Convex : Convexity::Concave;
+    }, TaskPriority::Normal, token);
+}
+
+vector<Feature> FeatureRecognizer::recognize(const CancelToken& token)
+{
+    Tracer::Span span("features", "analysis");
+    computeEdges(token);
+
+    /* one task per solid, the last one takes the faces outside any solid */
+    const int nbSolids = topoIndex.solidCount();
+    vector<vector<Feature>> perSolid(nbSolids + 1);
+    TaskScheduler::instance().parallelFor(0, nbSolids + 1, [&](int s)
+    {
+        vector<int> faces;
+        if (s < nbSolids)
+        {
+            TopoRange range = topoIndex.solidFaces(s);
+            faces.assign(range.begin(), range.end());
+        }
+        else
+        {
+            for (int f = 0; f < topoIndex.faceCount(); f++)
+            {
+                if (topoIndex.faceSolids(f).empty())
+                    faces.push_back(f);
+            }
+        }
+        /* the buffers of one solid come from the worker's arena, dropped together */
+        Arena::Scope arena;
+        recognizeFaces(s < nbSolids ? s : -1, faces, perSolid[s]);
+    }, TaskPriority::Normal, token);
+
+    vector<Feature> result;
+    for (auto& features : perSolid)
+        result.insert(result.end(), features.begin(), features.end());
+    return result;
+}
+
+void FeatureRecognizer::recognizeFaces(int solid, const vector<int>& faces, vector<Feature>& result) const
+{
+    recognizeCylinders(solid, faces, result);
+
+    for (int f : faces)
+    {
+        GeomAbs_SurfaceType surfType = faceTable.type[f];
+        if (surfType == GeomAbs_Torus && isSmoothBounded(f))
+        {
+            /* corner round between two fillets */
+            double longest = 0.0;
+            for (int e : topoIndex.faceEdges(f))
+                longest = std::max(longest, length[e]);
+
+            Feature feature;
+            feature.type = FeatureType::Fillet;
+            feature.solid = solid;
+            feature.faces.push_back(f);
+            feature.axis = gp_Ax1(faceTable.location[f], faceTable.direction[f]);
+            feature.diameter = faceTable.radius2[f] * 2.0;
+            feature.depth = longest;
+            result.push_back(feature);
+        }
+        else if (surfType == GeomAbs_Plane)
+        {
+            Feature feature;
+            if (isChamfer(f, feature))
+            {
+                feature.solid = solid;
+                result.push_back(feature);
+            }
+        }
+    }
+}
+
+void FeatureRecognizer::recognizeCylinders(int solid, const vector<int>& faces, vector<Feature>& result) const
+{
+    ArenaVector<int> cylinders = arenaVector<int>();
+    for (int f : faces)
+    {
+        if (faceTable.type[f] != GeomAbs_Cylinder)
+            continue;
+
+        /* a partial cylinder tangent to its neighbours is a fillet */
+        double span = faceTable.uMax[f] - faceTable.uMin[f];
+        if (span < M_PI && isSmoothBounded(f))
+        {
+            Feature feature;
+            feature.type = FeatureType::Fillet;
+            feature.solid = solid;
+            feature.faces.push_back(f);
+            feature.axis = gp_Ax1(faceTable.location[f], faceTable.direction[f]);
+            feature.diameter = faceTable.radius[f] * 2.0;
+            feature.depth = faceTable.vMax[f] - faceTable.vMin[f];
+            result.push_back(feature);
+        }
+        else
+        {
+            cylinders.push_back(f);
+        }
+    }
+
+    /* group the faces of one coaxial cylinder, holes are often split in halves */
+    std::sort(cylinders.begin(), cylinders.end(), [&](int a, int b) {
+        return faceTable.radius[a] < faceTable.radius[b];
+    });
+
+    ArenaVector<char> used = arenaVector<char>();
+    used.resize(cylinders.size(), 0);
+    ArenaVector<int> group = arenaVector<int>();
+    for (size_t i = 0; i < cylinders.size(); i++)
+    {
+        if (used[i])
+            continue;
+
+        const int ref = cylinders[i];
+        const gp_Dir& dir = faceTable.direction[ref];
+        const gp_Pnt& loc = faceTable.location[ref];
+        gp_Lin axisLine(loc, dir);
+
+        group.assign(1, ref);
+        for (size_t j = i + 1; j < cylinders.size(); j++)
+        {
+            int f = cylinders[j];
+            if (faceTable.radius[f] - faceTable.radius[ref] > linTol)
+                break;
+            if (used[j] || !faceTable.direction[f].IsParallel(dir, angTol))
+                continue;
+            if (axisLine.Distance(faceTable.location[f]) > linTol)
+                continue;
+            used[j] = 1;
+            group.push_back(f);
+        }
+
+        double span = 0.0;
+        double axMin = RealLast(), axMax = RealFirst();
+        for (int f : group)
+        {
+            span += faceTable.uMax[f] - faceTable.uMin[f];
+            /* v runs along each face axis, bring it onto the reference axis */
+            double offset = gp_Vec(loc, faceTable.location[f]).Dot(gp_Vec(dir));
+            double sign = faceTable.direction[f].Dot(dir) > 0.0 ? 1.0 : -1.0;
+            double a = offset + sign * faceTable.vMin[f];
+            double b = offset + sign * faceTable.vMax[f];
+            axMin = std::min(axMin, std::min(a, b));
+            axMax = std::max(axMax, std::max(a, b));
+        }
+
+        /* only closed cylinders are holes or bosses, slots are left alone */
+        if (span < 2.0 * M_PI - angTol)
+            continue;
+
+        Feature feature;
+        feature.type = isHoleSide(ref) ? FeatureType::Hole : FeatureType::Boss;
+        feature.solid = solid;
+        feature.faces.assign(group.begin(), group.end());
+        feature.axis = gp_Ax1(loc.Translated(gp_Vec(dir) * axMin), dir);
+        feature.diameter = faceTable.radius[ref] * 2.0;
+        feature.depth = axMax - axMin;
+        result.push_back(feature);
+    }
+}
+
+bool FeatureRecognizer::isChamfer(int face, Feature& feature) const
+{
+    TopoRange edges = topoIndex.faceEdges(face);
+    if (edges.size() != 4)
+        return false;
+
+    auto shareVertex = [&](int e1, int e2)
+    {
+        for (int v1 : topoIndex.edgeVertices(e1))
+            for (int v2 : topoIndex.edgeVertices(e2))
+                if (v1 == v2)
+                    return true;
+        return false;
+    };
+
+    /* the longest pair of opposite edges carries the chamfer */
+    int e1 = -1, e2 = -1;
+    double best = 0.0;
+    for (int a = 0; a < 4; a++)
+    {
+        for (int b = a + 1; b < 4; b++)
+        {
+            if (shareVertex(edges[a], edges[b]))
+                continue;
+            double len = length[edges[a]] + length[edges[b]];
+            if (len > best)
+            {
+                best = len;
+                e1 = edges[a];
+                e2 = edges[b];
+            }
+        }
+    }
+    if (e1 < 0)
+        return false;
+
+    Convexity c1 = convexity[e1];
+    Convexity c2 = convexity[e2];
+    if (c1 != c2 || (c1 != Convexity::Convex && c1 != Convexity::Concave))
+        return false;
+
+    int fa = otherFace(e1, face);
+    int fb = otherFace(e2, face);
+    if (fa < 0 || fb < 0)
+        return false;
+
+    /* planar neighbours must meet at an angle the chamfer cuts across */
+    const gp_Dir& normal = faceTable.direction[face];
+    if (faceTable.type[fa] == GeomAbs_Plane && faceTable.type[fb] == GeomAbs_Plane)
+    {
+        const gp_Dir& na = faceTable.direction[fa];
+        const gp_Dir& nb = faceTable.direction[fb];
+        const double minAng = 10.0 * M_PI / 180.0;
+        const double maxAng = 80.0 * M_PI / 180.0;
+        if (na.IsParallel(nb, angTol))
+            return false;
+        double angA = normal.Angle(na);
+        double angB = normal.Angle(nb);
+        if (angA < minAng || angA > maxAng || angB < minAng || angB > maxAng)
+            return false;
+    }
+
+    double len = std::max(length[e1], length[e2]);
+    if (len <= linTol)
+        return false;
+    double width = faceTable.area[face] / len;
+    if (width >= len)
+        return false;
+
+    feature.type = FeatureType::Chamfer;
+    feature.faces.assign(1, face);
+    feature.axis = gp_Ax1(faceTable.location[face], normal);
+    feature.diameter = width;
+    feature.depth = len;
+    return true;
+}
+
+bool FeatureRecognizer::isSmoothBounded(int face) const
+{
+    int smooth = 0;
+    for (int e : topoIndex.faceEdges(face))
+    {
+        if (convexity[e] == Convexity::Smooth)
+            smooth++;
+    }
+    return smooth >= 2;
+}
+
+int FeatureRecognizer::otherFace(int edge, int face) const
+{
+    TopoRange faces = topoIndex.edgeFaces(edge);
+    if (faces.size() != 2)
+        return -1;
+    return faces[0] == face ? faces[1] : faces[0];
+}
+
+bool FeatureRecognizer::isHoleSide(int face) const
+{
+    /* the matter is outside the cylinder when the normal points to the axis */
+    double u = (faceTable.uMin[face] + faceTable.uMax[face]) / 2.0;
+    double v = (faceTable.vMin[face] + faceTable.vMax[face]) / 2.0;
+
+    const TopoDS_Face& topoFace = topoIndex.face(face);
+    BRepAdaptor_Surface aSurf(topoFace, Standard_False);
+    gp_Pnt pnt;
+    gp_Vec du, dv;
+    aSurf.D1(u, v, pnt, du, dv);
+    gp_Vec normal = du.Crossed(dv);
+    if (topoFace.Orientation() == TopAbs_REVERSED)
+        normal.Reverse();
+
+    gp_Lin axisLine(faceTable.location[face], faceTable.direction[face]);
+    gp_Pnt foot = ElCLib::Value(ElCLib::Parameter(axisLine, pnt), axisLine);
+    gp_Vec radial(foot, pnt);
+    return normal.Dot(radial) < 0.0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "TopoIndex.h"
+#include "FaceTable.h"
+#include "TaskScheduler.h"
+#include <vector>
+#include <gp_Ax1.hxx>
+
+using std::vector;
+
+enum class FeatureType
+{
+	Hole,
+	Boss,
+	Fillet,
+	Chamfer
+};
+
+enum class Convexity
+{
+	Convex,
+	Concave,
+	Smooth,     //tangent faces
+	Boundary    //free, seam, degenerated or non-manifold edge
+};
+
+struct Feature
+{
+	FeatureType type;
+	int solid;            //solid id in the TopoIndex, -1 for faces outside solids
+	vector<int> faces;    //face ids in the TopoIndex
+	gp_Ax1 axis;          //hole/boss/fillet axis, chamfer face normal
+	double diameter;      //hole/boss diameter, fillet 2*radius, chamfer width
+	double depth;         //hole/boss depth along the axis, fillet/chamfer length
+};
+
+/*
+* FeatureRecognizer finds holes, bosses, fillets and chamfers from the
+* face table and the convexity of the edges between faces.
+* Edge convexity is computed once for all edges, then every solid is
+* recognized in its own task.
+*/
+class FeatureRecognizer
+{
+public:
+	FeatureRecognizer(const TopoIndex& index, const FaceTable& table);
+	~FeatureRecognizer();
+
+	vector<Feature> recognize(const CancelToken& token = CancelToken());
+	Convexity edgeConvexity(int edgeId) const;
+	double edgeLength(int edgeId) const;
+
+	static const char* typeName(FeatureType type);
+
+private:
+	void computeEdges(const CancelToken& token);
+	void recognizeFaces(int solid, const vector<int>& faces, vector<Feature>& result) const;
+	void recognizeCylinders(int solid, const vector<int>& faces, vector<Feature>& result) const;
+	bool isChamfer(int face, Feature& feature) const;
+	bool isSmoothBounded(int face) const;
+	int otherFace(int edge, int face) const;
+	bool isHoleSide(int face) const;
+
+private:
+	const TopoIndex& topoIndex;
+	const FaceTable& faceTable;
+	double angTol;
+	double linTol;
+
+	vector<Convexity> convexity;
+	vector<double> length;
+};
@@ -0,0 +1,99 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <QWidget>
+#include <QScreen>
+#include <QGuiApplication>
+
+FrameScheduler::FrameScheduler(QWidget* widget)
+    : QObject(widget), widget(widget), pending(FrameKind::None), isUpdateRequested(false), intervalMs(16), frames(0)
+{
+    /* one frame per refresh of the primary screen */
+    QScreen* screen = QGuiApplication::primaryScreen();
+    if (screen && screen->refreshRate() > 1.0)
+        intervalMs = std::max(1, static_cast<int>(1000.0 / screen->refreshRate()));
+
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &FrameScheduler::fire);
+    lastFrame.start();
+}
+
+FrameScheduler::~FrameScheduler()
+{
+
+}
+
+void FrameScheduler::request(FrameKind kind)
+{
+    if (kind > pending)
+        pending = kind;
+    if (pending == FrameKind::None || isUpdateRequested || timer.isActive())
+        return;
+
+    /* a frame was shown less than a refresh ago, wait for the next slot */
+    qint64 elapsed = lastFrame.elapsed();
+    if (elapsed >= intervalMs)
+        fire();
+    else
+        timer.start(static_cast<int>(intervalMs - elapsed));
+}
+
+FrameKind FrameScheduler::take()
+{
+    /* a paint nobody asked for (expose, resize) renders everything */
+    FrameKind kind = pending == FrameKind::None ? FrameKind::Full : pending;
+    pending = FrameKind::None;
+    isUpdateRequested = false;
+    timer.stop();
+    lastFrame.restart();
+    frames++;
+    return kind;
+}
+
+int FrameScheduler::interval() const
+{
+    return intervalMs;
+}
+
+long long FrameScheduler::frameCount() const
+{
+    return frames;
+}
+
+void FrameScheduler::fire(void)
+{
+    isUpdateRequested = true;
+    widget->update();
+}
+
+FrameView::FrameView(const Handle(V3d_Viewer)& viewer, FrameScheduler* scheduler)
+    : V3d_View(viewer), scheduler(scheduler), isPainting(false)
+{
+
+}
+
+void FrameView::Redraw() const
+{
+    if (isPainting)
+        V3d_View::Redraw();
+    else
+        scheduler->request(FrameKind::Full);
+}
+
+void FrameView::RedrawImmediate() const
+{
+    if (isPainting)
+        V3d_View::RedrawImmediate();
+    else
+        scheduler->request(FrameKind::Immediate);
+}
+
+void FrameView::paint(FrameKind kind)
+{
+    isPainting = true;
+    if (kind == FrameKind::Immediate)
+        RedrawImmediate();
+    else
+        Redraw();
+    isPainting = false;
+}
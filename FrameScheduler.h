@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <V3d_View.hxx>
+
+class QWidget;
+
+/* what the next frame has to render, a full frame covers an immediate one */
+enum class FrameKind
+{
+	None,
+	Immediate,  //highlight and other immediate layer changes only
+	Full
+};
+
+/*
+* FrameScheduler turns redraw requests into widget updates, at most one
+* per display refresh: requests between two frames only raise the pending
+* kind, and nothing is scheduled when nothing is requested.
+*/
+class FrameScheduler : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit FrameScheduler(QWidget* widget);
+	~FrameScheduler();
+
+	void request(FrameKind kind);
+	/* called by the paint, returns the pending kind and clears it */
+	FrameKind take();
+
+	int interval() const;
+	long long frameCount() const;
+
+private slots:
+	void fire(void);
+
+private:
+	QWidget* widget;
+	QTimer timer;
+	QElapsedTimer lastFrame;
+	FrameKind pending;
+	bool isUpdateRequested;
+	int intervalMs;
+	long long frames;
+};
+
+/*
+* FrameView routes every Redraw/RedrawImmediate the viewer, the context or
+* the camera helpers make to the scheduler. Only paint(), called with the
+* widget's GL context current, renders.
+*/
+class FrameView : public V3d_View
+{
+	DEFINE_STANDARD_RTTI_INLINE(FrameView, V3d_View)
+
+public:
+	FrameView(const Handle(V3d_Viewer)& viewer, FrameScheduler* scheduler);
+
+	virtual void Redraw() const override;
+	virtual void RedrawImmediate() const override;
+
+	void paint(FrameKind kind);
+
+private:
+	FrameScheduler* scheduler;
+	bool isPainting;
+};
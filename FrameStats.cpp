@@ -0,0 +1,107 @@
+#include "FrameStats.h"
+#include <algorithm>
+#include <QJsonArray>
+
+FrameStats::Scope::Scope(FrameStats& stats, StatKind kind)
+    : stats(stats), kind(kind), start(std::chrono::steady_clock::now()),
+    span(kindName(kind), kind == StatKind::Pick ? "selection" : "display")
+{
+
+}
+
+FrameStats::Scope::~Scope()
+{
+    stats.add(kind, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+FrameStats::FrameStats(int window) : window(std::max(1, window)), objectCount(0), triangleCount(0)
+{
+
+}
+
+FrameStats::~FrameStats()
+{
+
+}
+
+void FrameStats::add(StatKind kind, double ms)
+{
+    Series& s = series[static_cast<int>(kind)];
+    if (static_cast<int>(s.samples.size()) < window)
+        s.samples.push_back(ms);
+    else
+        s.samples[s.next] = ms;
+    s.next = (s.next + 1) % window;
+    s.total++;
+}
+
+void FrameStats::setScene(int nbObjects, int nbTriangles)
+{
+    objectCount = nbObjects;
+    triangleCount = nbTriangles;
+}
+
+void FrameStats::reset()
+{
+    for (Series& s : series)
+        s = Series();
+}
+
+long long FrameStats::count(StatKind kind) const
+{
+    return series[static_cast<int>(kind)].total;
+}
+
+double FrameStats::percentile(StatKind kind, double p) const
+{
+    vector<double> sorted = series[static_cast<int>(kind)].samples;
+    if (sorted.empty())
+        return 0.0;
+
+    size_t rank = static_cast<size_t>(std::min(1.0, std::max(0.0, p / 100.0)) * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+const char* FrameStats::kindName(StatKind kind)
+{
+    switch (kind)
+    {
+    case StatKind::Frame: return "frame";
+    case StatKind::Immediate: return "immediate";
+    case StatKind::Pick: return "pick";
+    case StatKind::Display: return "display";
+    default: return "unknown";
+    }
+}
+
+QJsonObject FrameStats::toJson() const
+{
+    QJsonObject obj;
+    for (int i = 0; i < static_cast<int>(StatKind::NbKinds); i++)
+    {
+        StatKind kind = static_cast<StatKind>(i);
+        obj[kindName(kind)] = QJsonObject{
+            { "count", static_cast<double>(count(kind)) },
+            { "window", static_cast<int>(series[i].samples.size()) },
+            { "p50", percentile(kind, 50.0) },
+            { "p90", percentile(kind, 90.0) },
+            { "p99", percentile(kind, 99.0) },
+            { "max", percentile(kind, 100.0) } };
+    }
+    obj["objects"] = objectCount;
+    obj["triangles"] = triangleCount;
+    return obj;
+}
+
+QString FrameStats::summary() const
+{
+    return QString("frame p50 %1 p99 %2 ms (%3)\npick p50 %4 p99 %5 ms (%6)\n"
+        "display p99 %7 ms (%8)\nobjects %9 triangles %10")
+        .arg(percentile(StatKind::Frame, 50.0), 0, 'f', 2).arg(percentile(StatKind::Frame, 99.0), 0, 'f', 2)
+        .arg(count(StatKind::Frame) + count(StatKind::Immediate))
+        .arg(percentile(StatKind::Pick, 50.0), 0, 'f', 2).arg(percentile(StatKind::Pick, 99.0), 0, 'f', 2)
+        .arg(count(StatKind::Pick))
+        .arg(percentile(StatKind::Display, 99.0), 0, 'f', 2).arg(count(StatKind::Display))
+        .arg(objectCount).arg(triangleCount);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <QString>
+#include <QJsonObject>
+#include "Tracer.h"
+
+using std::vector;
+
+enum class StatKind
+{
+	Frame,      //V3d_View::Redraw
+	Immediate,  //V3d_View::RedrawImmediate
+	Pick,       //MoveTo and Select
+	Display,    //AIS Display/Redisplay from Qcc
+	NbKinds
+};
+
+/*
+* FrameStats keeps the last samples of each kind in a ring buffer and
+* the total count since reset(). Percentiles are over the ring buffer,
+* so they follow what the viewer does now, not since startup.
+*/
+class FrameStats
+{
+public:
+	/* scoped cpu timer, adds one sample when it goes out of scope and a span to the trace */
+	class Scope
+	{
+	public:
+		Scope(FrameStats& stats, StatKind kind);
+		~Scope();
+
+	private:
+		FrameStats& stats;
+		StatKind kind;
+		std::chrono::steady_clock::time_point start;
+		Tracer::Span span;
+	};
+
+public:
+	explicit FrameStats(int window = 600);
+	~FrameStats();
+
+	void add(StatKind kind, double ms);
+	void setScene(int nbObjects, int nbTriangles);
+	void reset();
+
+	long long count(StatKind kind) const;
+	/* p in [0, 100] over the rolling window, 0 if there is no sample */
+	double percentile(StatKind kind, double p) const;
+
+	QJsonObject toJson() const;
+	QString summary() const;
+
+	static const char* kindName(StatKind kind);
+
+private:
+	struct Series
+	{
+		vector<double> samples;
+		size_t next = 0;
+		long long total = 0;
+	};
+
+	int window;
+	Series series[static_cast<int>(StatKind::NbKinds)];
+	int objectCount;
+	int triangleCount;
+};
@@ -0,0 +1,195 @@
+#include "ImportCache.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <streambuf>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QCoreApplication>
+
+#include <BinTools.hxx>
+#include <OSD_OpenFile.hxx>
+#include <Standard_Failure.hxx>
+
+static const char cacheMagic[8] = { 'Q', 'C', 'C', 'C', 'A', 'C', 'H', 'E' };
+static const uint32_t cacheVersion = 2;  //2: ids in TopExp::MapShapes order
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t shapeOffset;
+    uint64_t shapeSize;
+    uint64_t topoOffset;
+    uint64_t topoSize;
+};
+
+/* read-only istream buffer over a memory mapped block */
+class MemoryBuf : public std::streambuf
+{
+public:
+    MemoryBuf(const uchar* data, uint64_t size)
+    {
+        char* begin = reinterpret_cast<char*>(const_cast<uchar*>(data));
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override
+    {
+        char* pos = dir == std::ios_base::beg ? eback() + off
+            : dir == std::ios_base::cur ? gptr() + off : egptr() + off;
+        if (pos < eback() || pos > egptr())
+            return pos_type(off_type(-1));
+        setg(eback(), pos, egptr());
+        return pos_type(pos - eback());
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+ImportCache::ImportCache(const QString& dir) : cacheDir(dir)
+{
+    if (cacheDir.isEmpty())
+        cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/import";
+    QDir().mkpath(cacheDir);
+}
+
+ImportCache::~ImportCache()
+{
+
+}
+
+QString ImportCache::key(const QString& fileName) const
+{
+    QFileInfo info(fileName);
+    QFile file(fileName);
+    if (!info.exists() || !file.open(QIODevice::ReadOnly))
+        return QString();
+
+    QCryptographicHash content(QCryptographicHash::Sha1);
+    content.addData(&file);
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    hash.addData(content.result());
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString ImportCache::entryPath(const QString& key) const
+{
+    return cacheDir + "/" + key + ".qcc";
+}
+
+bool ImportCache::load(const QString& key, TopoDS_Shape& shp, std::shared_ptr<TopoIndex>& index) const
+{
+    if (key.isEmpty())
+        return false;
+
+    QFile file(entryPath(key));
+    if (!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(sizeof(CacheHeader)))
+        return false;
+
+    const uchar* data = file.map(0, file.size());
+    if (!data)
+        return false;
+
+    CacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    const uint64_t fileSize = static_cast<uint64_t>(file.size());
+    bool isOk = std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0
+        && header.version == cacheVersion
+        && header.shapeOffset <= fileSize && header.shapeSize <= fileSize - header.shapeOffset
+        && header.topoOffset <= fileSize && header.topoSize <= fileSize - header.topoOffset;
+
+    try
+    {
+        if (isOk)
+        {
+            MemoryBuf shapeBuf(data + header.shapeOffset, header.shapeSize);
+            std::istream shapeStream(&shapeBuf);
+            BinTools::Read(shp, shapeStream);
+            isOk = !shp.IsNull();
+        }
+        if (isOk)
+        {
+            MemoryBuf topoBuf(data + header.topoOffset, header.topoSize);
+            std::istream topoStream(&topoBuf);
+            index = std::make_shared<TopoIndex>();
+            isOk = index->read(shp, topoStream);
+        }
+    }
+    catch (const Standard_Failure&)
+    {
+        isOk = false;
+    }
+    file.unmap(const_cast<uchar*>(data));
+
+    /* a bad entry is a miss, the load stores a fresh one in its place */
+    if (!isOk)
+    {
+        shp.Nullify();
+        index.reset();
+        file.close();
+        QFile::remove(entryPath(key));
+    }
+    return isOk;
+}
+
+bool ImportCache::store(const QString& key, const TopoDS_Shape& shp, const TopoIndex& index) const
+{
+    if (key.isEmpty() || shp.IsNull())
+        return false;
+
+    /* another instance may have written the same entry meanwhile */
+    const QString path = entryPath(key);
+    if (QFile::exists(path))
+        return true;
+
+    const QString tmpPath = path + QString(".%1.tmp").arg(QCoreApplication::applicationPid());
+    std::ofstream out;
+    OSD_OpenStream(out, tmpPath.toUtf8().constData(), std::ios::out | std::ios::binary);
+    if (!out.is_open())
+        return false;
+
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    header.shapeOffset = static_cast<uint64_t>(out.tellp());
+    BinTools::Write(shp, out);
+    header.topoOffset = static_cast<uint64_t>(out.tellp());
+    header.shapeSize = header.topoOffset - header.shapeOffset;
+    index.write(out);
+    header.topoSize = static_cast<uint64_t>(out.tellp()) - header.topoOffset;
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (out.fail())
+    {
+        QFile::remove(tmpPath);
+        return false;
+    }
+
+    /* readers only ever see a complete entry */
+    if (!QFile::rename(tmpPath, path))
+    {
+        QFile::remove(tmpPath);
+        return QFile::exists(path);
+    }
+    return true;
+}
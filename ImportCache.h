@@ -0,0 +1,31 @@
+#pragma once
+
+#include "TopoIndex.h"
+#include <memory>
+#include <QString>
+#include <TopoDS_Shape.hxx>
+
+/*
+* ImportCache keeps transferred models in OCCT binary BRep format, with
+* their triangulations, followed by the TopoIndex csr arrays.
+* An entry is keyed by path, size, mtime and sha1 of the file content.
+* Entries are written to a temporary file and renamed into place, and
+* read through a read-only memory map, so several Qcc instances can
+* share one cache directory.
+*/
+class ImportCache
+{
+public:
+	explicit ImportCache(const QString& dir = QString());
+	~ImportCache();
+
+	/* empty if the file can not be read */
+	QString key(const QString& fileName) const;
+	QString entryPath(const QString& key) const;
+
+	bool load(const QString& key, TopoDS_Shape& shp, std::shared_ptr<TopoIndex>& index) const;
+	bool store(const QString& key, const TopoDS_Shape& shp, const TopoIndex& index) const;
+
+private:
+	QString cacheDir;
+};
@@ -1,5 +1,7 @@
 #include "Mesh.h"
 #include "ShapeHandle.hpp"
+#include "TaskScheduler.h"
+#include "Tracer.h"
 #include <TopLoc_Location.hxx>
 
 #include <BRepMesh_DelabellaMeshAlgoFactory.hxx>
@@ -27,7 +29,7 @@ void Mesh::setMeshParam()
     meshParam.AngleInterior = 1.0;
     meshParam.DeflectionInterior = 1.0;
     meshParam.MinSize = -1.0;
-    meshParam.InParallel = Standard_True;
+    meshParam.InParallel = TaskScheduler::instance().hasIdleThreads();
     meshParam.Relative = Standard_False;
     meshParam.InternalVerticesMode = Standard_True;
     meshParam.ControlSurfaceDeflection = Standard_True;
@@ -49,12 +51,24 @@ void Mesh::setMeshContext()
 
 void Mesh::makeTriangle(bool isCustom)
 {
+    Tracer::Span span("mesh", "mesh");
     if (isCustom)
     {
         setMeshParam();
         setMeshContext();
     }
 
+    /* count first, the triangles are stored in one block */
+    int nbTriangles = 0;
+    for (TopExp_Explorer exp(meshShape, TopAbs_FACE); exp.More(); exp.Next())
+    {
+        TopLoc_Location aLoc;
+        Handle(Poly_Triangulation) triMesh = BRep_Tool::Triangulation(TopoDS::Face(exp.Current()), aLoc);
+        if (triMesh)
+            nbTriangles += triMesh->NbTriangles();
+    }
+    triPnts.reserve(triPnts.size() + nbTriangles);
+
     for (TopExp_Explorer exp(meshShape, TopAbs_FACE); exp.More(); exp.Next())
     {
         TopLoc_Location aLoc;
@@ -62,40 +76,33 @@ void Mesh::makeTriangle(bool isCustom)
         Handle(Poly_Triangulation) triMesh = BRep_Tool::Triangulation(aFace, aLoc);
         if (triMesh)
         {
-            TColgp_Array1OfPnt aTriNodes(1, triMesh->NbNodes());
-            aTriNodes = triMesh->Nodes();
-
-            Poly_Array1OfTriangle aTriangles(1, triMesh->NbTriangles());
-            aTriangles = triMesh->Triangles();
+            /* read the arrays in place, no copy of the nodes and triangles */
+            const TColgp_Array1OfPnt& aTriNodes = triMesh->Nodes();
+            const Poly_Array1OfTriangle& aTriangles = triMesh->Triangles();
+            const gp_Trsf& aTrsf = aLoc.Transformation();
 
             //index start from 1 to 3 (not 0)
             for (int i = 1; i <= triMesh->NbTriangles(); i++)
             {
-                Poly_Triangle tri = aTriangles.Value(i);
                 Standard_Integer index1, index2, index3;
-                tri.Get(index1, index2, index3);
-
-                gp_Pnt pnt1, pnt2, pnt3;
-                pnt1 = aTriNodes[index1].Transformed(aLoc.Transformation());
-                pnt2 = aTriNodes[index2].Transformed(aLoc.Transformation());
-                pnt3 = aTriNodes[index3].Transformed(aLoc.Transformation());
+                aTriangles.Value(i).Get(index1, index2, index3);
 
-                if (pnt1.IsEqual(pnt2, 0.0001) || pnt2.IsEqual(pnt3, 0.0001) || pnt3.IsEqual(pnt1, 0.0001))
+                std::array<gp_Pnt, 3> triPnt = { aTriNodes[index1].Transformed(aTrsf),
+                    aTriNodes[index2].Transformed(aTrsf), aTriNodes[index3].Transformed(aTrsf) };
+                if (triPnt[0].IsEqual(triPnt[1], 0.0001) || triPnt[1].IsEqual(triPnt[2], 0.0001) || triPnt[2].IsEqual(triPnt[0], 0.0001))
                     continue;
-               
-                vector<gp_Pnt> triPnt;
-                triPnt.push_back(pnt1);
-                triPnt.push_back(pnt2);
-                triPnt.push_back(pnt3);
                 triPnts.push_back(triPnt);
             }
         }
     } 
+    span.arg("triangles", static_cast<double>(triPnts.size()));
 }
 
-void Mesh::displayTriangle()
+void Mesh::displayTriangle(QccView* myQccView, const gp_Trsf& pose)
 {
-    for (auto triPnt : triPnts)
+    /* one viewer update for all triangles */
+    DisplayBatch batch(myQccView);
+    for (const auto& triPnt : triPnts)
     {
         BRepBuilderAPI_MakePolygon mkPoly;
         mkPoly.Add(triPnt[0]);
@@ -107,7 +114,8 @@ void Mesh::displayTriangle()
         TopoDS_Shape topoFace = mkFace.Shape();
         Handle(AIS_Shape) aisFace = new AIS_Shape(topoFace);
         aisFace->SetColor(Quantity_NOC_DARKOLIVEGREEN4);
-        glbContext->Display(aisFace, Standard_False);
+        aisFace->SetLocalTransformation(pose);
+        myQccView->display(aisFace);
     }
 }
 
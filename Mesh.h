@@ -11,7 +11,7 @@
 
 #include <gp_Pnt.hxx>
 #include <vector>
-#include <thread>
+#include <array>
 
 class Mesh
 {
@@ -22,12 +22,13 @@ public:
 	void setMeshParam();
 	void setMeshContext();
 	void makeTriangle(bool isCustom = false);
-	void displayTriangle();
+	/* pose places the triangles where the shape is shown */
+	void displayTriangle(QccView* myQccView, const gp_Trsf& pose = gp_Trsf());
 	int countTriangle();
 
 private:
 	TopoDS_Shape meshShape;
-	vector<vector<gp_Pnt>> triPnts;
+	vector<std::array<gp_Pnt, 3>> triPnts;  //one allocation for all triangles, not one per triangle
 	BRepMesh_IncrementalMesh mesher;
 	IMeshTools_Parameters meshParam;
 	Handle(IMeshTools_Context) meshContext;
@@ -0,0 +1,209 @@
+#include "ModelGenerator.h"
+#include "Tracer.h"
+#include "MultiCut.h"
+#include <algorithm>
+#include <cmath>
+
+#include <gp_Ax1.hxx>
+#include <gp_Ax2.hxx>
+#include <gp_Quaternion.hxx>
+#include <BRep_Builder.hxx>
+#include <BRepBuilderAPI_MakeFace.hxx>
+#include <BRepBuilderAPI_MakePolygon.hxx>
+#include <BRepFilletAPI_MakeFillet.hxx>
+#include <BRepPrimAPI_MakeBox.hxx>
+#include <BRepPrimAPI_MakeCylinder.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopLoc_Location.hxx>
+#include <BRep_Tool.hxx>
+#include <TopExp.hxx>
+
+GeneratorOptions GeneratorOptions::fromJson(const QJsonObject& obj)
+{
+    GeneratorOptions options;
+    options.seed = static_cast<unsigned int>(obj["seed"].toDouble(options.seed));
+    options.parts = std::max(1, obj["parts"].toInt(options.parts));
+    options.unique = std::max(1, obj["unique"].toInt(options.unique));
+    options.holes = std::max(0, obj["holes"].toInt(options.holes));
+    options.fillet = std::max(0.0, obj["fillet"].toDouble(options.fillet));
+    options.pattern = std::max(1, obj["pattern"].toInt(options.pattern));
+    options.extent = obj["extent"].toDouble(options.extent);
+    options.triangles = std::max(0, obj["triangles"].toInt(options.triangles));
+    return options;
+}
+
+QJsonObject GeneratorOptions::toJson() const
+{
+    return QJsonObject{ { "seed", static_cast<double>(seed) }, { "parts", parts }, { "unique", unique },
+        { "holes", holes }, { "fillet", fillet }, { "pattern", pattern }, { "extent", extent },
+        { "triangles", triangles } };
+}
+
+ModelGenerator::ModelGenerator(const GeneratorOptions& options) : opts(options), rng(options.seed)
+{
+
+}
+
+ModelGenerator::~ModelGenerator()
+{
+
+}
+
+const GeneratorOptions& ModelGenerator::options() const
+{
+    return opts;
+}
+
+double ModelGenerator::uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * (rng() / 4294967296.0);
+}
+
+gp_Trsf ModelGenerator::randomPose()
+{
+    /* a random axis and angle, then a place inside the extent cube */
+    double z = uniform(-1.0, 1.0);
+    double phi = uniform(0.0, 2.0 * M_PI);
+    double r = std::sqrt(1.0 - z * z);
+    gp_Quaternion aRotation(gp_Vec(r * std::cos(phi), r * std::sin(phi), z), uniform(0.0, 2.0 * M_PI));
+
+    gp_Trsf aPose;
+    aPose.SetRotation(aRotation);
+    double half = opts.extent / 2.0;
+    aPose.SetTranslationPart(gp_Vec(uniform(-half, half), uniform(-half, half), uniform(-half, half)));
+    return aPose;
+}
+
+TopoDS_Shape ModelGenerator::part(int index)
+{
+    index %= opts.unique;
+    if (index < static_cast<int>(parts.size()) && !parts[index].IsNull())
+        return parts[index];
+    if (index >= static_cast<int>(parts.size()))
+        parts.resize(index + 1);
+
+    Tracer::Span span("generate part", "generate");
+    /* the sizes come from a generator of their own, a part does not depend on the call order */
+    std::mt19937 partRng(opts.seed * 7919u + static_cast<unsigned int>(index));
+    auto partUniform = [&partRng](double lo, double hi) { return lo + (hi - lo) * (partRng() / 4294967296.0); };
+    const double width = partUniform(20.0, 60.0);
+    const double depth = partUniform(20.0, 60.0);
+    const double height = partUniform(2.0, 8.0);
+
+    TopoDS_Shape aPlate = BRepPrimAPI_MakeBox(width, depth, height).Shape();
+    if (opts.fillet > 0.0)
+    {
+        /* round the four vertical edges */
+        BRepFilletAPI_MakeFillet aFillet(aPlate);
+        for (TopExp_Explorer exp(aPlate, TopAbs_EDGE); exp.More(); exp.Next())
+        {
+            const TopoDS_Edge& anEdge = TopoDS::Edge(exp.Current());
+            gp_Pnt p1 = BRep_Tool::Pnt(TopExp::FirstVertex(anEdge));
+            gp_Pnt p2 = BRep_Tool::Pnt(TopExp::LastVertex(anEdge));
+            if (std::abs(p1.X() - p2.X()) < 1e-9 && std::abs(p1.Y() - p2.Y()) < 1e-9)
+                aFillet.Add(std::min(opts.fillet, std::min(width, depth) / 4.0), anEdge);
+        }
+        aFillet.Build();
+        if (aFillet.IsDone())
+            aPlate = aFillet.Shape();
+    }
+
+    if (opts.holes > 0)
+    {
+        /* a grid of through holes away from the rounded corners, one cut for all */
+        const int nbCols = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(opts.holes))));
+        const int nbRows = (opts.holes + nbCols - 1) / nbCols;
+        const double margin = std::max(opts.fillet, 1.0) + 2.0;
+        const double pitchX = (width - 2.0 * margin) / nbCols;
+        const double pitchY = (depth - 2.0 * margin) / nbRows;
+
+        /* a large fillet leaves no room between the margins, the plate stays without holes */
+        if (pitchX > 0.0 && pitchY > 0.0)
+        {
+            const double radius = std::max(0.2, std::min(pitchX, pitchY) * 0.3);
+
+            /* one cylinder placed at every hole, the tools share its TShape */
+            TopoDS_Shape aCylinder = BRepPrimAPI_MakeCylinder(gp_Ax2(gp_Pnt(0.0, 0.0, -1.0), gp::DZ()), radius, height + 2.0).Shape();
+            vector<TopoDS_Shape> aTools;
+            for (int h = 0; h < opts.holes; h++)
+            {
+                gp_Trsf aTrsf;
+                aTrsf.SetTranslation(gp_Vec(margin + pitchX * (h % nbCols + 0.5), margin + pitchY * (h / nbCols + 0.5), 0.0));
+                aTools.push_back(aCylinder.Moved(TopLoc_Location(aTrsf)));
+            }
+            MultiCut aCut(aPlate, aTools);
+            if (aCut.perform())
+                aPlate = aCut.shape();
+        }
+    }
+
+    span.arg("index", index);
+    parts[index] = aPlate;
+    return aPlate;
+}
+
+TopoDS_Shape ModelGenerator::assembly()
+{
+    Tracer::Span span("generate assembly", "generate");
+    span.arg("parts", opts.parts);
+
+    TopoDS_Compound aCompound;
+    BRep_Builder aBuilder;
+    aBuilder.MakeCompound(aCompound);
+
+    /* rows of pattern repeats, each row at a random pose */
+    gp_Trsf aRowPose;
+    for (int i = 0; i < opts.parts; i++)
+    {
+        const int slot = i % opts.pattern;
+        const int row = i / opts.pattern;
+        if (slot == 0)
+            aRowPose = randomPose();
+
+        gp_Trsf aStep;
+        aStep.SetTranslation(gp_Vec(slot * 80.0, 0.0, 0.0));
+        TopoDS_Shape aPart = part(row % opts.unique);
+        aBuilder.Add(aCompound, aPart.Moved(TopLoc_Location(aRowPose * aStep)));
+    }
+    return aCompound;
+}
+
+vector<std::array<gp_Pnt, 3>> ModelGenerator::triangleSoup(int nbTriangles, double size)
+{
+    Tracer::Span span("generate soup", "generate");
+    span.arg("triangles", nbTriangles);
+
+    vector<std::array<gp_Pnt, 3>> soup;
+    soup.reserve(nbTriangles);
+    const double half = opts.extent / 2.0;
+    while (static_cast<int>(soup.size()) < nbTriangles)
+    {
+        gp_Pnt p(uniform(-half, half), uniform(-half, half), uniform(-half, half));
+        std::array<gp_Pnt, 3> tri = { p,
+            p.Translated(gp_Vec(uniform(-size, size), uniform(-size, size), uniform(-size, size))),
+            p.Translated(gp_Vec(uniform(-size, size), uniform(-size, size), uniform(-size, size))) };
+
+        /* degenerate triangles make no face, draw again */
+        gp_Vec aNormal = gp_Vec(tri[0], tri[1]).Crossed(gp_Vec(tri[0], tri[2]));
+        if (aNormal.Magnitude() > size * size * 1e-3)
+            soup.push_back(tri);
+    }
+    return soup;
+}
+
+TopoDS_Shape ModelGenerator::soupShape(const vector<std::array<gp_Pnt, 3>>& soup)
+{
+    TopoDS_Compound aCompound;
+    BRep_Builder aBuilder;
+    aBuilder.MakeCompound(aCompound);
+    for (const auto& tri : soup)
+    {
+        BRepBuilderAPI_MakePolygon mkPoly(tri[0], tri[1], tri[2], Standard_True);
+        BRepBuilderAPI_MakeFace mkFace(mkPoly.Wire(), Standard_True);
+        if (mkFace.IsDone())
+            aBuilder.Add(aCompound, mkFace.Face());
+    }
+    return aCompound;
+}
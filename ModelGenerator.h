@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <random>
+#include <vector>
+#include <QJsonObject>
+#include <gp_Pnt.hxx>
+#include <gp_Trsf.hxx>
+#include <TopoDS_Shape.hxx>
+
+using std::vector;
+
+/*
+* generator settings, read from json with the same keys:
+* {
+*   "seed":      1,       same seed and settings, same model on every machine
+*   "parts":     1000,    located parts of the assembly, 10 ... 100000
+*   "unique":    20,      distinct part shapes, the others repeat them
+*   "holes":     4,       through holes per part, cut as in Qcc::testCut
+*   "fillet":    0.5,     radius on the vertical edges, 0: none
+*   "pattern":   5,       parts per linear pattern row
+*   "extent":    2000,    rows are posed at random inside a cube of this size
+*   "triangles": 10000    triangle soup size
+* }
+*/
+struct GeneratorOptions
+{
+	unsigned int seed = 1;
+	int parts = 1000;
+	int unique = 20;
+	int holes = 4;
+	double fillet = 0.5;
+	int pattern = 5;
+	double extent = 2000.0;
+	int triangles = 10000;
+
+	static GeneratorOptions fromJson(const QJsonObject& obj);
+	QJsonObject toJson() const;
+};
+
+/*
+* ModelGenerator builds reproducible stress models. Each part is a plate
+* with a grid of holes and filleted corners, its face count follows the
+* holes and the fillets: 6 + holes + 4 with fillets. The assembly is a
+* compound of located parts that share the TShapes of the unique parts,
+* the way a STEP assembly does, so it displays through the instancer.
+* Only the std::mt19937 sequence is used, never a distribution or rand(),
+* whose results differ between standard libraries.
+*/
+class ModelGenerator
+{
+public:
+	explicit ModelGenerator(const GeneratorOptions& options);
+	~ModelGenerator();
+
+	/* the index-th unique part, at the origin */
+	TopoDS_Shape part(int index);
+	TopoDS_Shape assembly();
+	/* triangles with edges up to size inside the extent cube */
+	vector<std::array<gp_Pnt, 3>> triangleSoup(int nbTriangles, double size);
+	/* the soup as a compound of triangle faces, for the collision functions */
+	static TopoDS_Shape soupShape(const vector<std::array<gp_Pnt, 3>>& soup);
+
+	const GeneratorOptions& options() const;
+
+private:
+	/* uniform in [lo, hi) */
+	double uniform(double lo, double hi);
+	gp_Trsf randomPose();
+
+private:
+	GeneratorOptions opts;
+	std::mt19937 rng;
+	vector<TopoDS_Shape> parts;
+};
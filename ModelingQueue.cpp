@@ -0,0 +1,125 @@
+#include "ModelingQueue.h"
+#include "TaskScheduler.h"
+#include "Tracer.h"
+#include <chrono>
+#include <QStringList>
+#include <Message_ProgressScope.hxx>
+#include <Standard_Failure.hxx>
+
+ModelingQueue::ModelingQueue(const ModelingHandler& handler) : handler(handler), nextJob(1)
+{
+
+}
+
+ModelingQueue::~ModelingQueue()
+{
+    /* the workers only hold their own copies, wait for them before the watchers go */
+    cancelAll();
+    for (auto& item : jobs)
+    {
+        item.second.watcher->waitForFinished();
+        delete item.second.watcher;
+    }
+}
+
+int ModelingQueue::submit(const QString& name, const ModelingBuilder& builder)
+{
+    int id = nextJob++;
+    Job& aJob = jobs[id];
+    aJob.name = name;
+    aJob.progress = new Progress();
+    aJob.watcher = new QFutureWatcher<ModelingResult>();
+    QObject::connect(aJob.watcher, &QFutureWatcher<ModelingResult>::finished, aJob.watcher, [this, id]() {
+        finish(id);
+    });
+
+    Handle(Progress) aProgress = aJob.progress;
+    aJob.watcher->setFuture(TaskScheduler::instance().run([id, name, builder, aProgress]() {
+        Tracer::Span span("modeling", "modeling");
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ModelingResult result;
+        result.job = id;
+        result.name = name;
+        try
+        {
+            Message_ProgressScope scope(aProgress->Start(), "Modeling", 1);
+            result.parts = builder(scope.Next(), result.note);
+        }
+        catch (const Standard_Failure& failure)
+        {
+            result.error = failure.GetMessageString();
+        }
+        catch (const std::exception& e)
+        {
+            result.error = e.what();
+        }
+
+        /* an aborted builder may still return a partial shape, it is dropped */
+        result.isCanceled = aProgress->isCanceled();
+        if (result.isCanceled || !result.error.isEmpty())
+            result.parts.clear();
+        result.elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        span.arg("ms", result.elapsed);
+        return result;
+    }, TaskPriority::Interactive));
+    return id;
+}
+
+void ModelingQueue::cancel(int job)
+{
+    auto it = jobs.find(job);
+    if (it != jobs.end())
+        it->second.progress->cancel();
+}
+
+void ModelingQueue::cancelAll()
+{
+    for (auto& item : jobs)
+        item.second.progress->cancel();
+}
+
+int ModelingQueue::runningCount() const
+{
+    return static_cast<int>(jobs.size());
+}
+
+int ModelingQueue::progress() const
+{
+    if (jobs.empty())
+        return 0;
+    int sum = 0;
+    for (const auto& item : jobs)
+        sum += item.second.progress->percent();
+    return sum / static_cast<int>(jobs.size());
+}
+
+QString ModelingQueue::running() const
+{
+    QStringList names;
+    for (const auto& item : jobs)
+        names << item.second.name;
+    return names.join(", ");
+}
+
+void ModelingQueue::finish(int job)
+{
+    auto it = jobs.find(job);
+    if (it == jobs.end())
+        return;
+
+    QFutureWatcher<ModelingResult>* aWatcher = it->second.watcher;
+    ModelingResult result;
+    if (aWatcher->isCanceled())
+    {
+        result.job = job;
+        result.name = it->second.name;
+        result.error = "the task was dropped";
+    }
+    else
+    {
+        result = aWatcher->result();
+    }
+    jobs.erase(it);
+    aWatcher->deleteLater();  //we are inside its finished signal
+    handler(result);
+}
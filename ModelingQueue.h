@@ -0,0 +1,80 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <functional>
+#include <QString>
+#include <QFutureWatcher>
+#include <Message_ProgressRange.hxx>
+#include <Quantity_NameOfColor.hxx>
+#include <TopoDS_Shape.hxx>
+#include "Progress.h"
+
+using std::vector;
+
+/* one shape made by a job and the color it is shown with */
+struct ModelingPart
+{
+	TopoDS_Shape shape;
+	Quantity_NameOfColor color;
+};
+
+struct ModelingResult
+{
+	int job = 0;
+	QString name;
+	vector<ModelingPart> parts;
+	QString error;
+	QString note;           //what the builder reports, e.g. timings
+	bool isCanceled = false;
+	double elapsed = 0.0;   //ms on the worker
+};
+
+/*
+* builds the parts on a worker: reports through the range and stops when
+* it says UserBreak(), the note is shown with the result. Only value copies
+* of the input shapes may be used, nothing of the ui thread: a TopoDS_Shape
+* shares its TShapes with what is displayed, copy it with BRepBuilderAPI_Copy.
+*/
+typedef std::function<vector<ModelingPart>(const Message_ProgressRange&, QString& note)> ModelingBuilder;
+typedef std::function<void(const ModelingResult&)> ModelingHandler;
+
+/*
+* ModelingQueue runs modeling builders (fillet, boolean, sweep, loft) as
+* tasks of the TaskScheduler so the window stays live. Jobs are independent
+* and run concurrently; each has its own Progress to poll and to abort.
+* The handler is called on the ui thread with the result, a failed or
+* aborted job hands over no parts.
+*/
+class ModelingQueue
+{
+public:
+	explicit ModelingQueue(const ModelingHandler& handler);
+	~ModelingQueue();
+
+	/* returns the job id */
+	int submit(const QString& name, const ModelingBuilder& builder);
+	void cancel(int job);
+	void cancelAll();
+
+	int runningCount() const;
+	/* mean progress of the running jobs, 0 ... 100 */
+	int progress() const;
+	/* names of the running jobs, for the status bar */
+	QString running() const;
+
+private:
+	struct Job
+	{
+		QString name;
+		Handle(Progress) progress;
+		QFutureWatcher<ModelingResult>* watcher;
+	};
+
+	void finish(int job);
+
+private:
+	ModelingHandler handler;
+	std::map<int, Job> jobs;
+	int nextJob;
+};
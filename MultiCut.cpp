@@ -0,0 +1,119 @@
+#include "MultiCut.h"
+#include "Tracer.h"
+#include <chrono>
+#include <BRepAlgoAPI_Cut.hxx>
+#include <Message_ProgressScope.hxx>
+#include <TopTools_ListOfShape.hxx>
+
+typedef std::chrono::steady_clock Clock;
+
+namespace
+{
+    double msSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+MultiCut::MultiCut(const TopoDS_Shape& object, const vector<TopoDS_Shape>& tools)
+    : object(object), tools(tools), fuzzyValue(1.0e-5), isParallel(true), useObb(true), elapsedMs(0.0)
+{
+
+}
+
+MultiCut::~MultiCut()
+{
+
+}
+
+void MultiCut::setFuzzyValue(double value)
+{
+    fuzzyValue = value;
+}
+
+void MultiCut::setRunParallel(bool isOn)
+{
+    isParallel = isOn;
+}
+
+void MultiCut::setUseObb(bool isOn)
+{
+    useObb = isOn;
+}
+
+bool MultiCut::perform(const Message_ProgressRange& theRange)
+{
+    Tracer::Span span("multi cut", "modeling");
+    span.arg("tools", static_cast<double>(tools.size()));
+    Clock::time_point start = Clock::now();
+    result.Nullify();
+
+    TopTools_ListOfShape anArguments, aTools;
+    anArguments.Append(object);
+    for (const TopoDS_Shape& tool : tools)
+        aTools.Append(tool);
+
+    BRepAlgoAPI_Cut aCut;
+    aCut.SetArguments(anArguments);
+    aCut.SetTools(aTools);
+    aCut.SetRunParallel(isParallel);
+    aCut.SetFuzzyValue(fuzzyValue);
+    aCut.SetUseOBB(useObb);
+    aCut.SetNonDestructive(Standard_True);
+    aCut.Build(theRange);
+
+    elapsedMs = msSince(start);
+    if (!aCut.IsDone() || aCut.HasErrors())
+        return false;
+    result = aCut.Shape();
+    return true;
+}
+
+bool MultiCut::performChained(const Message_ProgressRange& theRange)
+{
+    Tracer::Span span("chained cut", "modeling");
+    span.arg("tools", static_cast<double>(tools.size()));
+    Clock::time_point start = Clock::now();
+    result.Nullify();
+
+    Message_ProgressScope aScope(theRange, "Chained cut", static_cast<double>(tools.size()));
+    TopoDS_Shape aShape = object;
+    for (const TopoDS_Shape& tool : tools)
+    {
+        if (!aScope.More())
+        {
+            elapsedMs = msSince(start);
+            return false;
+        }
+        TopTools_ListOfShape anArguments, aTools;
+        anArguments.Append(aShape);
+        aTools.Append(tool);
+
+        BRepAlgoAPI_Cut aCut;
+        aCut.SetArguments(anArguments);
+        aCut.SetTools(aTools);
+        aCut.SetFuzzyValue(fuzzyValue);
+        aCut.SetNonDestructive(Standard_True);
+        aCut.Build(aScope.Next());
+        if (!aCut.IsDone() || aCut.HasErrors())
+        {
+            elapsedMs = msSince(start);
+            return false;
+        }
+        aShape = aCut.Shape();
+    }
+
+    elapsedMs = msSince(start);
+    result = aShape;
+    return true;
+}
+
+const TopoDS_Shape& MultiCut::shape() const
+{
+    return result;
+}
+
+double MultiCut::elapsed() const
+{
+    return elapsedMs;
+}
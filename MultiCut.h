@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <Message_ProgressRange.hxx>
+#include <TopoDS_Shape.hxx>
+
+using std::vector;
+
+/*
+* MultiCut subtracts N tools from one object in a single General Fuse pass:
+* the object and the tools are intersected once, instead of every chained
+* BRepAlgoAPI_Cut intersecting the growing result again. The pass runs in
+* parallel, with a fuzzy tolerance for coincident faces of pattern tools and
+* with OBB pre-filtering of the pairs to intersect. The inputs are not
+* modified, tools may share their TShapes.
+*/
+class MultiCut
+{
+public:
+	MultiCut(const TopoDS_Shape& object, const vector<TopoDS_Shape>& tools);
+	~MultiCut();
+
+	void setFuzzyValue(double value);
+	void setRunParallel(bool isOn);
+	void setUseObb(bool isOn);
+
+	bool perform(const Message_ProgressRange& theRange = Message_ProgressRange());
+	/* the same cut as one BRepAlgoAPI_Cut per tool, to compare with */
+	bool performChained(const Message_ProgressRange& theRange = Message_ProgressRange());
+
+	const TopoDS_Shape& shape() const;
+	/* ms of the last perform */
+	double elapsed() const;
+
+private:
+	TopoDS_Shape object;
+	vector<TopoDS_Shape> tools;
+	double fuzzyValue;
+	bool isParallel;
+	bool useObb;
+	TopoDS_Shape result;
+	double elapsedMs;
+};
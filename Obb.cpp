@@ -1,35 +1,49 @@
 #include "Obb.h"
+#include "QccView.h"
 #include "ShapeHandle.hpp"
+#include "ObbOverlay.h"
+#include "TaskScheduler.h"
+#include "Tracer.h"
+#include "Arena.h"
+#include <TopExp.hxx>
 #include <TopExp_Explorer.hxx>
-
-class QccView;
+#include <TopoDS.hxx>
+#include <BRep_Tool.hxx>
 
 Obb::Obb(TopoDS_Shape topoShp) : topoShape(topoShp)
 {
     if (topoShp.IsNull())
         return;
 
+    Tracer::Span span("obb", "obb");
     /* shape obb contruction */
     BRepBndLib repbnd;  //obbShape is Bnd_OBB
     repbnd.AddOBB(topoShape, obbShape, true, true, false);
 
-    /* face obb list construction */
+    vector<TopoDS_Face> faces;
     for (TopExp_Explorer exp(topoShape, TopAbs_FACE); exp.More(); exp.Next())
+        faces.push_back(TopoDS::Face(exp.Current()));
+
+    /* face obb list construction, read only so one task per face */
+    obbList.resize(faces.size());
+    TaskScheduler::instance().parallelFor(0, static_cast<int>(faces.size()), [&](int i)
     {
         BRepBndLib facebnd;
-        Bnd_OBB obbface;
-        facebnd.AddOBB(exp.Value(), obbface, true, true, false);
-        obbList.push_back(obbface);
-        //discrete face to triangles and save to triList 
-        TopoDS_Face topoface = TopoDS::Face(exp.Current());
+        facebnd.AddOBB(faces[i], obbList[i], true, true, false);
+    }, TaskPriority::Interactive);
+
+    /* discrete face to triangles and save to triList, in turn: neighbour faces share their edges */
+    Tracer::Span triSpan("obb triangles", "obb");
+    for (TopoDS_Face& topoface : faces)
         triList.push_back(Hand::geneFaceTri(topoface));
-    }
+    span.arg("faces", static_cast<double>(faces.size()));
 }
 
 Obb::Obb(std::vector<TopoDS_Shape> topoShps)
 {
     std::vector<gp_Pnt> pntList;
-    for (auto shp : topoShps)
+    pntList.reserve(topoShps.size() * 8);
+    for (const auto& shp : topoShps)
     {
         Bnd_OBB obb;
         BRepBndLib build_bnd;
@@ -50,42 +64,40 @@ Obb::~Obb()
 
 }
 
-void Obb::displayObb(const QccView* myQccView, ObbLevel obblv)
+void Obb::displayObb(QccView* myQccView, ObbLevel obblv, const gp_Trsf& pose)
 {
-    int count = 0;
+    Tracer::Span span("obb overlay", "display");
+    /* one overlay object per level, not one shape per box or triangle */
+    Handle(ObbOverlay) overlay = new ObbOverlay();
     if (obblv == ObbLevel::ObbTriangle)
     {
         if (triList.size() == 0)
             return;
         /* create bndOBB for selected shape */
-        for (auto tri : triList)
+        for (const auto& tri : triList)
         {
-            count += tri.size();
-            for (auto t : tri)
+            for (const auto& t : tri)
             {
-                TopoDS_Shape topo(t);
-                Handle(AIS_Shape) aistri = new AIS_Shape(topo);
-                aistri->SetColor(Quantity_NOC_GREEN);
-                aistri->SetTransparency(0.9);
-                myQccView->getContext()->Display(aistri, Standard_False);
+                /* the first vertex of each oriented edge gives the corners in order */
+                gp_Pnt pnt[3];
+                int n = 0;
+                for (TopExp_Explorer exp(t, TopAbs_EDGE); exp.More() && n < 3; exp.Next())
+                    pnt[n++] = BRep_Tool::Pnt(TopExp::FirstVertex(TopoDS::Edge(exp.Current()), Standard_True));
+                if (n == 3)
+                    overlay->addTriangle(pnt[0], pnt[1], pnt[2]);
             }
-            myQccView->getContext()->UpdateCurrentViewer();
         }
-        qDebug() << "Obb total triangles are:" << count;
+        span.arg("triangles", overlay->triangleCount());
     }
     else if (obblv == ObbLevel::ObbFace)
     {
         for (const auto& fbb : obbList)
         {
-            count++;
-            TopoDS_Shape fObb = Hand::getBndShape(fbb);
-            Handle(AIS_Shape) aface = new AIS_Shape(fObb);
-            aface->SetColor(Quantity_NOC_GREEN);
-            aface->SetTransparency(0.9);
-            myQccView->getContext()->Display(aface, Standard_False);
+            Bnd_OBB fObb = fbb;
+            fObb.Enlarge(0.01); //just for display bndBox
+            overlay->addBox(fObb);
         }
-        myQccView->getContext()->UpdateCurrentViewer();
-        qDebug() << "Obb total faces are:" << count;
+        span.arg("boxes", overlay->boxCount());
     }
     else if (obblv == ObbLevel::ObbShape)
     {
@@ -101,12 +113,10 @@ void Obb::displayObb(const QccView* myQccView, ObbLevel obblv)
         obbShape.SetYComponent(yDir, y - 5);
         obbShape.SetZComponent(zDir, z - 5);
 
-        TopoDS_Shape topoObb = Hand::getBndShape(obbShape);
-        Handle(AIS_Shape) abox = new AIS_Shape(topoObb);
-        abox->SetColor(Quantity_NOC_GREEN);
-        abox->SetTransparency(0.9);
-        myQccView->getContext()->Display(abox, Standard_True);
+        overlay->addBox(obbShape);
     }
+    overlay->SetLocalTransformation(pose);
+    myQccView->display(overlay, 0, -1);  //not selectable
 }
 
 double Obb::getArea()
@@ -128,35 +138,40 @@ Standard_Boolean Obb::isValid()
     }
 }
 
-Bnd_OBB Obb::Bnd_OBB_genWithPoints(std::vector<gp_Pnt> Points)
+Bnd_OBB Obb::Bnd_OBB_genWithPoints(const std::vector<gp_Pnt>& Points)
 {
     //ɷַ(PCA)
     Bnd_OBB retObb;
+    const int nbRows = static_cast<int>(Points.size());
+    if (nbRows < 2)
+        return retObb;
+
+    /* the Nx3 sample matrix only lives for this call, it takes the thread's arena */
+    Arena::Scope arena;
     // Nx3 ľ
-    math_Matrix X(0, Points.size()-1, 0, 2);
-    for (int i = 0; i < Points.size(); i++)
+    math_Matrix X(Arena::allocator()->Allocate(sizeof(double) * nbRows * 3), 0, nbRows - 1, 0, 2);
+    for (int i = 0; i < nbRows; i++)
     {
         X(i, 0) = Points[i].X();
         X(i, 1) = Points[i].Y();
         X(i, 2) = Points[i].Z();
     }
-    //һάȾֵ
-    math_Vector meanVal(0, 2, 0.0);
-    for (int i = 0; i < X.RowNumber(); i++)
+    //һάȾֵ, element by element: Row() would copy every row
+    double meanVal[3] = { 0.0, 0.0, 0.0 };
+    for (int i = 0; i < nbRows; i++)
     {
-        meanVal += X.Row(i);
+        for (int k = 0; k < 3; k++)
+            meanVal[k] += X(i, k);
     }
-    meanVal /= X.RowNumber();
-    math_Vector meanVecRow(meanVal);
-    //ֵΪ0
-    math_Matrix X2(X);
-    for (int i = 0; i < X2.RowNumber(); i++)
+    //ֵΪ0, in place
+    for (int i = 0; i < nbRows; i++)
     {
-        X2.Row(i) -= meanVecRow;
+        for (int k = 0; k < 3; k++)
+            X(i, k) -= meanVal[k] / nbRows;
     }
     //Э: C= XT*X/(n-1)
-    math_Matrix C2 = X2.Transposed() * X2;
-    C2 = C2 / (X2.RowNumber() - 1.0);
+    math_Matrix C2 = X.TMultiply(X);
+    C2 = C2 / (nbRows - 1.0);
     //ȡֵ 
 
 
@@ -1,7 +1,5 @@
 #pragma once
 
-#include "Qcc.h"
-#include "QccView.h"
 #include <vector>
 #include <TopoDS_Shape.hxx>
 #include <TopoDS_Face.hxx>
@@ -16,6 +14,8 @@
 
 using std::vector;
 
+class QccView;
+
 enum class ObbLevel
 {
 	ObbShape,
@@ -30,10 +30,11 @@ public:
 	explicit Obb(std::vector<TopoDS_Shape>);
 	~Obb();
 
-	void displayObb(const QccView* myQccView, ObbLevel obblv = ObbLevel::ObbShape);
+	/* pose places the boxes where the shape is shown */
+	void displayObb(QccView* myQccView, ObbLevel obblv = ObbLevel::ObbShape, const gp_Trsf& pose = gp_Trsf());
 	double getArea(void);
 	Standard_Boolean isValid(void);
-	Bnd_OBB Bnd_OBB_genWithPoints(std::vector<gp_Pnt> Points);
+	Bnd_OBB Bnd_OBB_genWithPoints(const std::vector<gp_Pnt>& Points);
 
 public:
 	TopoDS_Shape topoShape;
@@ -0,0 +1,114 @@
+#include "ObbOverlay.h"
+
+#include <Graphic3d_ArrayOfSegments.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <Graphic3d_Group.hxx>
+#include <Prs3d_LineAspect.hxx>
+#include <Prs3d_ShadingAspect.hxx>
+#include <Prs3d_Presentation.hxx>
+
+/*
+* GetVertex corner i is the center -x/+x for bit 0, -y/+y for bit 1 and
+* -z/+z for bit 2, an edge joins corners differing in one bit
+*/
+static const int boxEdges[24] = { 0, 1, 2, 3, 4, 5, 6, 7, 0, 2, 1, 3, 4, 6, 5, 7, 0, 4, 1, 5, 2, 6, 3, 7 };
+static const int boxTriangles[36] = {
+    0, 2, 1, 1, 2, 3,   //-z
+    4, 5, 6, 5, 7, 6,   //+z
+    0, 1, 4, 1, 5, 4,   //-y
+    2, 6, 3, 3, 6, 7,   //+y
+    0, 4, 2, 2, 4, 6,   //-x
+    1, 3, 5, 3, 7, 5 }; //+x
+
+ObbOverlay::ObbOverlay(const Quantity_Color& color, double transparency)
+{
+    /* unlit, the overlay keeps its color whatever the light */
+    Handle(Prs3d_ShadingAspect) aFill = new Prs3d_ShadingAspect();
+    aFill->SetColor(color);
+    aFill->SetTransparency(transparency);
+    aFill->Aspect()->SetShadingModel(Graphic3d_TOSM_UNLIT);
+    myDrawer->SetShadingAspect(aFill);
+    myDrawer->SetLineAspect(new Prs3d_LineAspect(color, Aspect_TOL_SOLID, 1.0));
+    SetDisplayMode(0);
+}
+
+void ObbOverlay::addBox(const Bnd_OBB& obb)
+{
+    gp_Pnt vertex[8];
+    obb.GetVertex(vertex);
+    boxVertices.insert(boxVertices.end(), vertex, vertex + 8);
+}
+
+void ObbOverlay::addTriangle(const gp_Pnt& p1, const gp_Pnt& p2, const gp_Pnt& p3)
+{
+    triVertices.push_back(p1);
+    triVertices.push_back(p2);
+    triVertices.push_back(p3);
+}
+
+int ObbOverlay::boxCount() const
+{
+    return static_cast<int>(boxVertices.size() / 8);
+}
+
+int ObbOverlay::triangleCount() const
+{
+    return static_cast<int>(triVertices.size() / 3);
+}
+
+void ObbOverlay::Compute(const Handle(PrsMgr_PresentationManager3d)& /*thePrsMgr*/,
+    const Handle(Prs3d_Presentation)& thePrs, const Standard_Integer theMode)
+{
+    if (theMode != 0)
+        return;
+
+    int nbBoxes = boxCount();
+    int nbTriangles = triangleCount();
+    int nbFillVertices = nbBoxes * 8 + nbTriangles * 3;
+    if (nbFillVertices == 0)
+        return;
+
+    /* box faces and loose triangles share one indexed triangle array */
+    Handle(Graphic3d_ArrayOfTriangles) aFill =
+        new Graphic3d_ArrayOfTriangles(nbFillVertices, nbBoxes * 36 + nbTriangles * 3);
+    for (const gp_Pnt& aPnt : boxVertices)
+        aFill->AddVertex(aPnt);
+    for (const gp_Pnt& aPnt : triVertices)
+        aFill->AddVertex(aPnt);
+    for (int b = 0; b < nbBoxes; b++)
+    {
+        for (int i = 0; i < 36; i += 3)
+            aFill->AddEdges(b * 8 + boxTriangles[i] + 1, b * 8 + boxTriangles[i + 1] + 1, b * 8 + boxTriangles[i + 2] + 1);
+    }
+    for (int t = 0; t < nbTriangles; t++)
+    {
+        int first = nbBoxes * 8 + t * 3 + 1;
+        aFill->AddEdges(first, first + 1, first + 2);
+    }
+
+    Handle(Graphic3d_Group) aFillGroup = thePrs->NewGroup();
+    aFillGroup->SetClosed(false);
+    aFillGroup->SetGroupPrimitivesAspect(myDrawer->ShadingAspect()->Aspect());
+    aFillGroup->AddPrimitiveArray(aFill);
+
+    if (nbBoxes == 0)
+        return;
+
+    Handle(Graphic3d_ArrayOfSegments) anEdges = new Graphic3d_ArrayOfSegments(nbBoxes * 8, nbBoxes * 24);
+    for (const gp_Pnt& aPnt : boxVertices)
+        anEdges->AddVertex(aPnt);
+    for (int b = 0; b < nbBoxes; b++)
+    {
+        for (int i = 0; i < 24; i += 2)
+            anEdges->AddEdges(b * 8 + boxEdges[i] + 1, b * 8 + boxEdges[i + 1] + 1);
+    }
+
+    Handle(Graphic3d_Group) anEdgeGroup = thePrs->NewGroup();
+    anEdgeGroup->SetGroupPrimitivesAspect(myDrawer->LineAspect()->Aspect());
+    anEdgeGroup->AddPrimitiveArray(anEdges);
+}
+
+void ObbOverlay::ComputeSelection(const Handle(SelectMgr_Selection)& /*theSel*/, const Standard_Integer /*theMode*/)
+{
+    /* display only */
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <gp_Pnt.hxx>
+#include <Bnd_OBB.hxx>
+#include <Quantity_Color.hxx>
+#include <AIS_InteractiveObject.hxx>
+
+using std::vector;
+
+/*
+* ObbOverlay draws any number of oriented boxes and triangles as one
+* presentation: a transparent unlit triangle array for the fill and a
+* segment array for the box edges, with the box corners taken straight
+* from Bnd_OBB::GetVertex. It is display only and never selectable.
+*/
+class ObbOverlay : public AIS_InteractiveObject
+{
+	DEFINE_STANDARD_RTTI_INLINE(ObbOverlay, AIS_InteractiveObject)
+
+public:
+	explicit ObbOverlay(const Quantity_Color& color = Quantity_Color(Quantity_NOC_GREEN), double transparency = 0.9);
+
+	void addBox(const Bnd_OBB& obb);
+	void addTriangle(const gp_Pnt& p1, const gp_Pnt& p2, const gp_Pnt& p3);
+
+	int boxCount() const;
+	int triangleCount() const;
+
+	virtual Standard_Boolean AcceptDisplayMode(const Standard_Integer theMode) const override { return theMode == 0; }
+
+private:
+	virtual void Compute(const Handle(PrsMgr_PresentationManager3d)& thePrsMgr,
+		const Handle(Prs3d_Presentation)& thePrs, const Standard_Integer theMode) override;
+	virtual void ComputeSelection(const Handle(SelectMgr_Selection)& theSel, const Standard_Integer theMode) override;
+
+private:
+	vector<gp_Pnt> boxVertices;  //8 per box, in Bnd_OBB::GetVertex order
+	vector<gp_Pnt> triVertices;  //3 per triangle
+};
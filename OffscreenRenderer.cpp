@@ -0,0 +1,177 @@
+#include "OffscreenRenderer.h"
+#include <chrono>
+
+#include <AIS_Shape.hxx>
+#include <AIS_InteractiveContext.hxx>
+#include <Aspect_DisplayConnection.hxx>
+#include <Image_AlienPixMap.hxx>
+#include <Image_Diff.hxx>
+#include <OpenGl_GraphicDriver.hxx>
+#include <Prs3d_Drawer.hxx>
+#include <Prs3d_ShadingAspect.hxx>
+#include <Standard_Failure.hxx>
+#include <V3d_View.hxx>
+#include <V3d_Viewer.hxx>
+#include <V3d_ImageDumpOptions.hxx>
+
+#ifdef _WIN32
+#include <WNT_Window.hxx>
+#include <WNT_WClass.hxx>
+#else
+#include <Xw_Window.hxx>
+#include <X11/Xlib.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+OffscreenRenderer::OffscreenRenderer(const RenderOptions& options) : renderOptions(options), renderMs(0.0)
+{
+    try
+    {
+        /* throws on linux when there is no X display */
+        Handle(Aspect_DisplayConnection) aDisplayConnection = new Aspect_DisplayConnection();
+        myDriver = new OpenGl_GraphicDriver(aDisplayConnection, Standard_False);
+        myDriver->ChangeOptions().buffersNoSwap = Standard_True;
+        myDriver->ChangeOptions().swapInterval = 0;
+        if (!myDriver->InitContext())
+        {
+            lastError = "can not create a GL context";
+            myDriver.Nullify();
+            return;
+        }
+
+#ifdef _WIN32
+        Handle(WNT_WClass) aClass = new WNT_WClass("Qcc_Offscreen", (Standard_Address)DefWindowProcW, CS_OWNDC);
+        Handle(WNT_Window) wind = new WNT_Window("Qcc", aClass, WS_POPUP, 0, 0, options.width, options.height);
+#else
+        Handle(Xw_Window) wind = new Xw_Window(aDisplayConnection, "Qcc", 0, 0, options.width, options.height);
+#endif
+        wind->SetVirtual(Standard_True);
+
+        myViewer = new V3d_Viewer(myDriver);
+        myViewer->SetDefaultLights();
+        myViewer->SetLightOn();
+        myContext = new AIS_InteractiveContext(myViewer);
+        myContext->SetDisplayMode(AIS_Shaded, Standard_False);
+        myContext->DefaultDrawer()->SetFaceBoundaryDraw(options.withEdges);
+        myContext->DefaultDrawer()->ShadingAspect()->SetColor(options.color);
+
+        myView = myViewer->CreateView();
+        myView->SetWindow(wind);
+        myView->SetBackgroundColor(options.background);
+        myView->SetProj(options.orientation);
+    }
+    catch (const Standard_Failure& failure)
+    {
+        lastError = failure.GetMessageString();
+        myView.Nullify();
+        myContext.Nullify();
+        myViewer.Nullify();
+        myDriver.Nullify();
+    }
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    if (!myView.IsNull())
+        myView->Remove();
+}
+
+bool OffscreenRenderer::isValid() const
+{
+    return !myView.IsNull();
+}
+
+const std::string& OffscreenRenderer::error() const
+{
+    return lastError;
+}
+
+void OffscreenRenderer::initThreads()
+{
+    /* each renderer opens its own display, xlib must know about threads first */
+#ifndef _WIN32
+    XInitThreads();
+#endif
+}
+
+void OffscreenRenderer::clear()
+{
+    if (isValid())
+        myContext->RemoveAll(Standard_False);
+}
+
+void OffscreenRenderer::add(const TopoDS_Shape& shp)
+{
+    if (!isValid() || shp.IsNull())
+        return;
+    Handle(AIS_Shape) anAisShape = new AIS_Shape(shp);
+    myContext->Display(anAisShape, AIS_Shaded, -1, Standard_False);  //no selection
+}
+
+bool OffscreenRenderer::render(Image_PixMap& image)
+{
+    if (!isValid())
+        return false;
+
+    Clock::time_point start = Clock::now();
+    myView->SetProj(renderOptions.orientation);
+    myView->FitAll(0.05, Standard_False);
+
+    V3d_ImageDumpOptions dumpOptions;
+    dumpOptions.Width = renderOptions.width;
+    dumpOptions.Height = renderOptions.height;
+    dumpOptions.BufferType = Graphic3d_BT_RGB;
+    bool isDone = myView->ToPixMap(image, dumpOptions) == Standard_True;
+    renderMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    if (!isDone)
+        lastError = "dump to image failed";
+    return isDone;
+}
+
+bool OffscreenRenderer::dump(const std::string& fileName)
+{
+    Image_AlienPixMap image;
+    if (!render(image))
+        return false;
+    if (!image.Save(fileName.c_str()))
+    {
+        lastError = "can not save " + fileName;
+        return false;
+    }
+    return true;
+}
+
+double OffscreenRenderer::frameTime(int nbFrames)
+{
+    if (!isValid() || nbFrames <= 0)
+        return 0.0;
+
+    /* invalidate so every redraw goes through the whole scene, not the cached frame */
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < nbFrames; i++)
+    {
+        myView->Invalidate();
+        myView->Redraw();
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / nbFrames;
+}
+
+double OffscreenRenderer::renderTime() const
+{
+    return renderMs;
+}
+
+int OffscreenRenderer::compare(const std::string& fileName, const std::string& reference, double tolerance)
+{
+    Handle(Image_AlienPixMap) anImage = new Image_AlienPixMap();
+    Handle(Image_AlienPixMap) aReference = new Image_AlienPixMap();
+    if (!anImage->Load(fileName.c_str()) || !aReference->Load(reference.c_str()))
+        return -1;
+
+    Image_Diff aComparer;
+    if (!aComparer.Init(aReference, anImage))
+        return -1;
+    aComparer.SetColorTolerance(tolerance);
+    return aComparer.Compare();
+}
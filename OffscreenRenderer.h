@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <TopoDS_Shape.hxx>
+#include <Quantity_Color.hxx>
+#include <V3d_TypeOfOrientation.hxx>
+
+class Image_PixMap;
+class V3d_View;
+class V3d_Viewer;
+class AIS_InteractiveContext;
+class OpenGl_GraphicDriver;
+
+struct RenderOptions
+{
+	int width = 256;
+	int height = 256;
+	bool withEdges = true;
+	V3d_TypeOfOrientation orientation = V3d_XposYnegZpos;
+	Quantity_Color background = Quantity_Color(Quantity_NOC_WHITE);
+	Quantity_Color color = Quantity_Color(Quantity_NOC_GRAY70);
+};
+
+/*
+* OffscreenRenderer owns its own driver, viewer and context bound to a
+* virtual (never mapped) window, and renders into a framebuffer of the
+* requested size with V3d_View::ToPixMap. The GL context belongs to the
+* thread that created the renderer, so batch workers keep one each.
+* On linux it still needs an X display: a headless box runs under Xvfb,
+* with LIBGL_ALWAYS_SOFTWARE=1 for mesa's software rasterizer.
+*/
+class OffscreenRenderer
+{
+public:
+	explicit OffscreenRenderer(const RenderOptions& options = RenderOptions());
+	~OffscreenRenderer();
+
+	/* false when there is no display or no GL context */
+	bool isValid() const;
+	const std::string& error() const;
+
+	/* call once before renderers are created on several threads */
+	static void initThreads();
+
+	void clear();
+	void add(const TopoDS_Shape& shp);
+
+	/* fit the scene and render it, returns false if the dump failed */
+	bool render(Image_PixMap& image);
+	/* render and save, the format follows the suffix (png, bmp, ppm...) */
+	bool dump(const std::string& fileName);
+	/* average time of nbFrames full redraws, for viewer regressions */
+	double frameTime(int nbFrames);
+
+	double renderTime() const;
+
+	/*
+	* number of pixels differing by more than the tolerance (0-1 color
+	* distance) from a reference image, -1 if the images can not be compared
+	*/
+	static int compare(const std::string& fileName, const std::string& reference, double tolerance);
+
+private:
+	RenderOptions renderOptions;
+	std::string lastError;
+	double renderMs;
+
+	Handle(OpenGl_GraphicDriver) myDriver;
+	Handle(V3d_Viewer) myViewer;
+	Handle(V3d_View) myView;
+	Handle(AIS_InteractiveContext) myContext;
+};
@@ -0,0 +1,37 @@
+#include "Progress.h"
+
+Progress::Progress() : curPercent(0), toCancel(false)
+{
+
+}
+
+Progress::~Progress()
+{
+
+}
+
+int Progress::percent() const
+{
+    return curPercent.load(std::memory_order_relaxed);
+}
+
+void Progress::cancel()
+{
+    toCancel.store(true, std::memory_order_relaxed);
+}
+
+bool Progress::isCanceled() const
+{
+    return toCancel.load(std::memory_order_relaxed);
+}
+
+Standard_Boolean Progress::UserBreak()
+{
+    return isCanceled();
+}
+
+void Progress::Show(const Message_ProgressScope&, const Standard_Boolean)
+{
+    /* called under the indicator mutex, keep it to one store */
+    curPercent.store(static_cast<int>(GetPosition() * 100.0), std::memory_order_relaxed);
+}
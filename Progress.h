@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <Message_ProgressIndicator.hxx>
+
+/*
+* Progress is filled in by OCCT algorithms on a worker thread and
+* polled from the ui thread, no Qt call crosses the thread boundary.
+*/
+class Progress : public Message_ProgressIndicator
+{
+	DEFINE_STANDARD_RTTI_INLINE(Progress, Message_ProgressIndicator)
+
+public:
+	Progress();
+	~Progress();
+
+	/* 0 ... 100 */
+	int percent() const;
+	void cancel();
+	bool isCanceled() const;
+
+	virtual Standard_Boolean UserBreak() Standard_OVERRIDE;
+
+protected:
+	virtual void Show(const Message_ProgressScope& theScope, const Standard_Boolean isForce) Standard_OVERRIDE;
+
+private:
+	std::atomic<int> curPercent;
+	std::atomic<bool> toCancel;
+};
@@ -3,9 +3,12 @@
 #include "Mesh.h"
 #include "QccView.h"
 #include "ShapeHandle.hpp"
-#include <omp.h>
+#include "Tracer.h"
+#include "MultiCut.h"
 #include <time.h>
 #include <exception>
+#include <stdexcept>
+#include <climits>
 #include <QTime>
 #include <QDebug>
 #include <QToolBar>
@@ -13,10 +16,17 @@
 #include <QMessageBox>
 #include <QDockWidget>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QStandardPaths>
+#include <QDir>
 #include <QJsonObject>
 #include <QJsonDocument>
 
 #include <BRep_Tool.hxx>
+#include <BRep_Builder.hxx>
+#include <Precision.hxx>
+#include <TopoDS_Compound.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
 #include <Geom_Curve.hxx>
 #include <GeomLProp_SLProps.hxx>
 #include <GeomAdaptor_Curve.hxx>
@@ -40,9 +50,12 @@
 
 #include <Standard_ErrorHandler.hxx>
 #include <Standard_Failure.hxx>
+#include <Message_ProgressScope.hxx>
 
 Qcc::Qcc(QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::QccClass)
+    : QMainWindow(parent), ui(new Ui::QccClass), meshedId(NoObject), meshedRevision(0),
+    analysisId(NoObject), analysisRevision(0), isAutoSaving(false),
+    modeling([this](const ModelingResult& result) { modeled(result); })
 {
     ui->setupUi(this);
     myQccView = new QccView(this);
@@ -55,6 +68,34 @@ Qcc::Qcc(QWidget *parent)
 
     myStatusBar = new QStatusBar(this);
     this->setStatusBar(myStatusBar);
+    saveBar = new QProgressBar(myStatusBar);
+    saveBar->setRange(0, 100);
+    saveBar->setMaximumWidth(160);
+    saveBar->hide();
+    myStatusBar->addPermanentWidget(saveBar);
+    modelBar = new QProgressBar(myStatusBar);
+    modelBar->setRange(0, 100);
+    modelBar->setMaximumWidth(160);
+    modelBar->hide();
+    myStatusBar->addPermanentWidget(modelBar);
+
+    /* auto-save every 5 minutes when the displayed shapes changed */
+    progressTimer.setInterval(100);
+    modelTimer.setInterval(100);
+    streamTimer.setInterval(50);
+    lazyTimer.setInterval(200);
+    lazyTimer.setSingleShot(true);
+    autoSaveTimer.setInterval(5 * 60 * 1000);
+    autoSaveTimer.start();
+
+    /* abort every running modeling job */
+    ui->menuModeling->addSeparator();
+    QAction* cancelModeling = new QAction;
+    cancelModeling->setIconText(tr("Cancel Modeling"));
+    ui->menuModeling->addAction(cancelModeling);
+    connect(cancelModeling, &QAction::triggered, this, [this]() {
+        modeling.cancelAll();
+    });
 
     ui->menuPrimitive->addSeparator();
     /* make a cylinder with hollow */
@@ -68,10 +109,67 @@ Qcc::Qcc(QWidget *parent)
     facehole->setIconText(tr("Hole"));
     ui->menuPrimitive->addAction(facehole);
     connect(facehole, &QAction::triggered, this, &Qcc::makeFaceHole);
+
+    /* open an assembly with its parts transferred on demand */
+    QAction* lazyLoad = new QAction;
+    lazyLoad->setIconText(tr("Load Assembly"));
+    ui->menuFile->insertAction(ui->actionSave, lazyLoad);
+    connect(lazyLoad, &QAction::triggered, this, &Qcc::loadAssembly);
+
+    /* reproducible stress model, the same seed gives the same parts and poses */
+    QAction* generate = new QAction;
+    generate->setIconText(tr("Generate Model"));
+    ui->menuFile->insertAction(ui->actionSave, generate);
+    connect(generate, &QAction::triggered, this, &Qcc::generateModel);
+
+    /* select while the rubber band is dragged, not only on release */
+    ui->menuView->addSeparator();
+    QAction* selectionPreview = new QAction;
+    selectionPreview->setIconText(tr("Selection Preview"));
+    selectionPreview->setCheckable(true);
+    ui->menuView->addAction(selectionPreview);
+    connect(selectionPreview, &QAction::toggled, myQccView, &QccView::setSelectionPreview);
+
+    /* frame time overlay and its export */
+    QAction* frameStats = new QAction;
+    frameStats->setIconText(tr("Frame Stats"));
+    frameStats->setCheckable(true);
+    ui->menuView->addAction(frameStats);
+    connect(frameStats, &QAction::toggled, myQccView, &QccView::showStats);
+    QAction* exportStats = new QAction;
+    exportStats->setIconText(tr("Export Frame Stats"));
+    ui->menuView->addAction(exportStats);
+    connect(exportStats, &QAction::triggered, this, [this]() {
+        QString fileName = QFileDialog::getSaveFileName(this, tr("Export Frame Stats"), "D:/stats.json", "*.json");
+        if (!fileName.isEmpty() && !myQccView->exportStats(fileName))
+            myStatusBar->showMessage(tr("Can not write %1").arg(fileName));
+    });
+
+    /* record spans of every phase while checked, written when unchecked */
+    QAction* recordTrace = new QAction;
+    recordTrace->setIconText(tr("Record Trace"));
+    recordTrace->setCheckable(true);
+    recordTrace->setChecked(Tracer::isEnabled());
+    ui->menuView->addAction(recordTrace);
+    connect(recordTrace, &QAction::toggled, this, [this](bool isOn) {
+        Tracer::setEnabled(isOn);
+        if (isOn)
+        {
+            Tracer::clear();
+            return;
+        }
+        QString fileName = QFileDialog::getSaveFileName(this, tr("Save Trace"), "D:/trace.json", "*.json");
+        if (!fileName.isEmpty() && !Tracer::write(fileName.toLocal8Bit().data()))
+            myStatusBar->showMessage(tr("Can not write %1").arg(fileName));
+    });
 }
 
 Qcc::~Qcc()
 {
+    /* an auto-save does not hold up closing, its .part file is dropped; a user save is finished */
+    if (writer && isAutoSaving)
+        writer->cancel();
+    saveWatcher.waitForFinished();
     delete myQccView;
     delete ui;
 }
@@ -115,6 +213,27 @@ void Qcc::createActions(void)
     connect(myQccView, &QccView::anlsSig, this, &Qcc::anlsShape);
     connect(myQccView, &QccView::deleteSig, this, &Qcc::deleteShape);
     connect(myQccView, &QccView::selectSig, this, &Qcc::selectShape);
+    connect(myQccView, &QccView::moveSig, this, &Qcc::moved);
+
+    connect(&loadWatcher, &QFutureWatcher<std::shared_ptr<StepLoader>>::finished, this, &Qcc::loaded);
+    connect(&meshWatcher, &QFutureWatcher<std::shared_ptr<Mesh>>::finished, this, &Qcc::meshed);
+    connect(&topoWatcher, &QFutureWatcher<std::shared_ptr<TopoIndex>>::finished, this, &Qcc::topoIndexed);
+    connect(&faceWatcher, &QFutureWatcher<std::shared_ptr<FaceTable>>::finished, this, &Qcc::faceClassified);
+    connect(&propsWatcher, &QFutureWatcher<std::shared_ptr<ShapeProperties>>::finished, this, &Qcc::propertiesComputed);
+    connect(&featureWatcher, &QFutureWatcher<std::shared_ptr<vector<Feature>>>::finished, this, &Qcc::featureRecognized);
+    connect(&saveWatcher, &QFutureWatcher<bool>::finished, this, &Qcc::saved);
+    connect(&progressTimer, &QTimer::timeout, this, &Qcc::saveProgress);
+    connect(&modelTimer, &QTimer::timeout, this, &Qcc::modelingProgress);
+    connect(&streamTimer, &QTimer::timeout, this, &Qcc::streamed);
+    connect(&assemblyWatcher, &QFutureWatcher<std::shared_ptr<AssemblyLoader>>::finished, this, &Qcc::assemblyRead);
+    connect(&partWatcher, &QFutureWatcher<vector<int>>::finished, this, &Qcc::partsLoaded);
+    connect(&generateWatcher, &QFutureWatcher<std::pair<TopoDS_Shape, Handle(ObbOverlay)>>::finished, this, &Qcc::generated);
+    connect(&lazyTimer, &QTimer::timeout, this, &Qcc::updateLazy);
+    connect(myQccView, &QccView::viewChanged, this, [this]() {
+        if (assembly)
+            lazyTimer.start();
+    });
+    connect(&autoSaveTimer, &QTimer::timeout, this, &Qcc::autoSave);
 }
 
 void Qcc::createMenus(void)
@@ -181,16 +300,18 @@ void Qcc::about()
 
 void Qcc::test()
 {
-    if (selectedShape.empty())
+    if (document.selection().empty())
         return;
 
-    Obb obbShps(selectedShape);
+    Obb obbShps(document.selection());
     obbShps.displayObb(myQccView);
 }
 
 void Qcc::erase()
 {
-    myQccView->getContext()->EraseAll(Standard_True);
+    myQccView->eraseAll();
+    myQccView->instancer().clear();
+    document.clear();
 }
 
 void Qcc::anlsShape()
@@ -199,6 +320,11 @@ void Qcc::anlsShape()
     {
         Handle(AIS_InteractiveObject) aisObj = myQccView->getContext()->DetectedInteractive();
         TopoDS_Shape topoShp = myQccView->getContext()->DetectedShape();
+        if (requireLazy(aisObj))
+        {
+            myStatusBar->showMessage(tr("Loading the part, analyse again when it is shown"));
+            return;
+        }
         
         Handle(SelectMgr_EntityOwner) owner = myQccView->getContext()->DetectedOwner();
         Handle(AIS_InteractiveObject) aisEnty = Handle(AIS_InteractiveObject)::DownCast(owner->Selectable());
@@ -207,48 +333,96 @@ void Qcc::anlsShape()
         
         //qDebug() << topoShp.IsEqual(aisOwn);  //is true
 
+        /* artifacts of the active object, missing while they are computed */
+        const DocObject* anActive = document.object(document.active());
+        std::shared_ptr<TopoIndex> topoIndex;
+        std::shared_ptr<FaceTable> faceTable;
+        std::shared_ptr<vector<Feature>> features;
+        if (anActive)
+        {
+            topoIndex = anActive->topology.isValid() ? anActive->topology.value : nullptr;
+            faceTable = anActive->faces.isValid() ? anActive->faces.value : nullptr;
+            features = anActive->features.isValid() ? anActive->features.value : nullptr;
+        }
+
         int count = 0;
         switch (myQccView->getSelectMode())
         {
         case 6:
         {   //How many faces included by this solid
-            for (TopExp_Explorer exp(topoShp, TopAbs_FACE); exp.More(); exp.Next())
+            int solid = topoIndex ? topoIndex->solidId(topoShp) : -1;
+            if (solid >= 0)
             {
-                TopoDS_Face face = TopoDS::Face(exp.Value());
-                count++;
+                count = topoIndex->solidFaces(solid).size();
+            }
+            else
+            {
+                for (TopExp_Explorer exp(topoShp, TopAbs_FACE); exp.More(); exp.Next())
+                    count++;
             }
             QString info = QString("Face Number: %1").arg(count);
+            if (features && solid >= 0)
+            {   //features recognized on this solid
+                int holes = 0, bosses = 0, fillets = 0, chamfers = 0;
+                for (const Feature& feature : *features)
+                {
+                    if (feature.solid != solid)
+                        continue;
+                    switch (feature.type)
+                    {
+                    case FeatureType::Hole: holes++; break;
+                    case FeatureType::Boss: bosses++; break;
+                    case FeatureType::Fillet: fillets++; break;
+                    case FeatureType::Chamfer: chamfers++; break;
+                    }
+                }
+                info += QString(", Holes: %1, Bosses: %2, Fillets: %3, Chamfers: %4")
+                    .arg(holes).arg(bosses).arg(fillets).arg(chamfers);
+            }
             myStatusBar->showMessage(info);
             break;
         }
         case 4:
         {   //How many edges included by this face
             TopoDS_Face face = TopoDS::Face(topoShp);
-            for (TopExp_Explorer exp(topoShp, TopAbs_EDGE); exp.More(); exp.Next())
+            int faceId = topoIndex ? topoIndex->faceId(face) : -1;
+            if (faceId >= 0)
             {
-                TopoDS_Edge edge = TopoDS::Edge(exp.Value());
-                count++;
+                count = topoIndex->faceEdges(faceId).size();
+            }
+            else
+            {
+                for (TopExp_Explorer exp(topoShp, TopAbs_EDGE); exp.More(); exp.Next())
+                    count++;
             }
 
             gp_Vec normal = Hand::getPlaneNormal(face);
             qDebug() << normal.X() << normal.Y() << normal.Z() << ":" << face.Orientation();
             QString info = QString("Edge Number: %4").arg(count);
+            if (faceTable && faceId >= 0)
+            {   //faces of the same type and radius
+                int similar = static_cast<int>(faceTable->selectSimilar(faceId).size());
+                info += QString(", %1 R=%2, Similar Faces: %3").arg(FaceTable::typeName(faceTable->type[faceId]))
+                    .arg(faceTable->radius[faceId]).arg(similar);
+            }
             myStatusBar->showMessage(info);
             break;
         }
         case 2:
         {   //What faces commoned this edge
             TopoDS_Edge edge = TopoDS::Edge(topoShp);
-            if (edgeFaceMap.Contains(edge))
+            int edgeId = topoIndex ? topoIndex->edgeId(edge) : -1;
+            if (edgeId >= 0)
             {
-                TopoDS_ListOfShape findFace = edgeFaceMap.FindFromKey(edge);
-                if (findFace.Size() != 2)
+                if (topoIndex->edgeFaces(edgeId).size() != 2)
                 {
                     qDebug() << "It's not a 2-face shared edge";
                     return;
                 } 
                 //calculate two surface dihedral angle
-                double angle = Hand::getDihedralAngle(edge, findFace, currentShape);
+                TopoDS_ListOfShape findFace = topoIndex->edgeFaceList(edgeId);
+                TopoDS_Shape anActiveShape = anActive->shape;
+                double angle = Hand::getDihedralAngle(myQccView->getContext(), edge, findFace, anActiveShape);
                 qDebug() << "Dihedral Angle:" << angle << "\n";
             }
             //calulate edge length
@@ -267,79 +441,242 @@ void Qcc::anlsShape()
             break;
         }
         case 0: default:
-        {   //Transfer context to shape and recursive it
+        {   //Make the picked object active and index it
             //Handle(AIS_Shape) aisShape = Handle(AIS_Shape)::DownCast(aisObj);  //is not same?
-            currentShape = topoShp;
-            edgeFaceMap.Clear();
-            edgeMap.Clear();
-            for (TopExp_Explorer exp(topoShp, TopAbs_FACE); exp.More(); exp.Next())
-            {
-                TopoDS_Face face = TopoDS::Face(exp.Value());
-                TopExp::MapShapesAndAncestors(face, TopAbs_EDGE, TopAbs_FACE, edgeFaceMap);
-                count++;
-            }
-            for (TopExp_Explorer exp(topoShp, TopAbs_EDGE); exp.More(); exp.Next())
-            {
-                TopoDS_Edge edge = TopoDS::Edge(exp.Value());
-                if (!edgeMap.Contains(edge))
-                    TopExp::MapShapes(edge, TopAbs_EDGE, edgeMap);
-            }   
-            QString info = QString("Face Number: %1, Edge Number: %2").arg(count).arg(edgeMap.Size());
-            myStatusBar->showMessage(info);
+            ObjectId id = document.acquire(aisObj);
+            document.setActive(id);
+            autoDetect(id);
             break;
         }
         }
     }
 }
 
-int Qcc::autoDetect(const TopoDS_Shape& topoShp)
+void Qcc::autoDetect(ObjectId id)
 {
-    int count = 0;
-    TopTools_IndexedDataMapOfShapeListOfShape egfcMap;
-    TopTools_IndexedMapOfShape egMap;
-    for (TopExp_Explorer exp(topoShp, TopAbs_FACE); exp.More(); exp.Next())
+    /* a new chain for the object, results of the previous one are dropped */
+    analysisToken.cancel();
+    analysisToken = CancelToken();
+    const DocObject* anObject = document.object(id);
+    if (!anObject)
+        return;
+    analysisId = id;
+    analysisRevision = anObject->revision;
+
+    TopoDS_Shape topoShp = anObject->shape;
+    if (!anObject->properties.isValid())
     {
-        TopoDS_Face face = TopoDS::Face(exp.Value());
-        TopExp::MapShapesAndAncestors(face, TopAbs_EDGE, TopAbs_FACE, egfcMap);
-        count++;
+        propsWatcher.setFuture(TaskScheduler::instance().run([topoShp]() {
+            return ShapeProperties::compute(topoShp);
+        }, TaskPriority::Normal, analysisToken));
     }
-    edgeFaceMap = egfcMap;
 
-    for (TopExp_Explorer exp(topoShp, TopAbs_EDGE); exp.More(); exp.Next())
+    /* index the topology off the ui thread, topoIndexed() takes the result */
+    if (anObject->topology.isValid())
     {
-        TopoDS_Edge edge = TopoDS::Edge(exp.Value());
-        if (!egMap.Contains(edge))
-            TopExp::MapShapes(edge, TopAbs_EDGE, egMap);
-    } 
-    edgeMap = egMap;
+        setTopoIndex(anObject->topology.value);
+        return;
+    }
+    topoWatcher.setFuture(TaskScheduler::instance().run([topoShp]() {
+        return std::make_shared<TopoIndex>(topoShp);
+    }, TaskPriority::Normal, analysisToken));
+    myStatusBar->showMessage(tr("Indexing topology..."));
+}
 
-    QString info = QString("Face Number: %1, Edge Number: %2").arg(count).arg(egMap.Size());
+void Qcc::topoIndexed()
+{
+    if (topoWatcher.isCanceled())
+        return;
+    std::shared_ptr<TopoIndex> index = topoWatcher.result();
+    const DocObject* anObject = document.object(analysisId);
+    if (!anObject || !index->shape().IsEqual(anObject->shape))
+        return;  //another object is being indexed
+    if (!document.attach(analysisId, analysisRevision, &DocObject::topology, index))
+        return;
+    setTopoIndex(index);
+}
+
+void Qcc::propertiesComputed()
+{
+    if (propsWatcher.isCanceled())
+        return;
+    std::shared_ptr<ShapeProperties> props = propsWatcher.result();
+    const DocObject* anObject = document.object(analysisId);
+    if (!anObject || !props->shape.IsEqual(anObject->shape))
+        return;
+    if (!document.attach(analysisId, analysisRevision, &DocObject::properties, props))
+        return;
+    myStatusBar->showMessage(QString("Volume: %1, Area: %2").arg(props->volume).arg(props->area));
+}
+
+void Qcc::moved(const Handle(AIS_InteractiveObject)& obj)
+{
+    /* the artifacts stay, an object shown by this one presentation takes its pose */
+    DocObject* anObject = document.object(document.objectOf(obj));
+    if (!anObject)
+        return;
+    if (anObject->presentations.size() == 1)
+    {
+        document.setPose(anObject->id, obj->LocalTransformation());
+        return;
+    }
+
+    /* a moved part of a larger object leaves it, acquire() makes it one of its own at the new pose */
+    document.unbind(obj);
+    document.acquire(obj);
+}
+
+void Qcc::setTopoIndex(const std::shared_ptr<TopoIndex>& index)
+{
+    QString info = QString("Face Number: %1, Edge Number: %2").arg(index->faceCount()).arg(index->edgeCount());
     myStatusBar->showMessage(info);
 
-    return count;
+    /* classify the faces of the new index, faceClassified() takes the table */
+    const DocObject* anObject = document.object(analysisId);
+    if (anObject && anObject->faces.isValid())
+    {
+        setFaceTable(anObject->faces.value);
+        return;
+    }
+    CancelToken token = analysisToken;
+    faceWatcher.setFuture(TaskScheduler::instance().run([index, token]() {
+        std::shared_ptr<FaceTable> table = std::make_shared<FaceTable>(*index, token);
+        return token.isCancelled() ? std::shared_ptr<FaceTable>() : table;
+    }, TaskPriority::Normal, token));
 }
 
-void Qcc::meshShape(bool isCustom)
+void Qcc::faceClassified()
 {
-    if (myQccView->getContext()->HasDetectedShape())
+    if (faceWatcher.isCanceled())
+        return;
+    std::shared_ptr<FaceTable> table = faceWatcher.result();
+    if (!table)
+        return;  //cancelled halfway, the rows are incomplete
+    const DocObject* anObject = document.object(analysisId);
+    if (!anObject || !table->shape().IsEqual(anObject->shape))
+        return;  //the object changed meanwhile
+    if (!document.attach(analysisId, analysisRevision, &DocObject::faces, table))
+        return;
+    setFaceTable(table);
+}
+
+void Qcc::setFaceTable(const std::shared_ptr<FaceTable>& table)
+{
+    vector<int> hist = table->typeHistogram();
+    myStatusBar->showMessage(QString("Face Number: %1, Planes: %2, Cylinders: %3, Cones: %4, Spheres: %5, Tori: %6, BSplines: %7")
+        .arg(table->size()).arg(hist[GeomAbs_Plane]).arg(hist[GeomAbs_Cylinder]).arg(hist[GeomAbs_Cone])
+        .arg(hist[GeomAbs_Sphere]).arg(hist[GeomAbs_Torus]).arg(hist[GeomAbs_BSplineSurface]));
+
+    /* recognize the features, featureRecognized() takes the list */
+    const DocObject* anObject = document.object(analysisId);
+    if (!anObject || !anObject->topology.isValid())
+        return;
+    if (anObject->features.isValid())
     {
-        Handle(AIS_InteractiveObject) aisObj = myQccView->getContext()->DetectedInteractive();
-        myQccView->getContext()->Erase(aisObj, Standard_True);
+        setFeatures(anObject->features.value);
+        return;
+    }
+    std::shared_ptr<TopoIndex> index = anObject->topology.value;
+    CancelToken token = analysisToken;
+    featureWatcher.setFuture(TaskScheduler::instance().run([index, table, token]() {
+        FeatureRecognizer recognizer(*index, *table);
+        std::shared_ptr<vector<Feature>> found = std::make_shared<vector<Feature>>(recognizer.recognize(token));
+        return token.isCancelled() ? std::shared_ptr<vector<Feature>>() : found;
+    }, TaskPriority::Normal, token));
+}
+
+void Qcc::featureRecognized()
+{
+    if (featureWatcher.isCanceled())
+        return;
+    std::shared_ptr<vector<Feature>> found = featureWatcher.result();
+    if (!found)
+        return;
+    /* the list belongs to the active chain only while it waits for its features */
+    const DocObject* anObject = document.object(analysisId);
+    if (!anObject || !anObject->faces.isValid() || anObject->features.isValid())
+        return;
+    if (!document.attach(analysisId, analysisRevision, &DocObject::features, found))
+        return;
+    setFeatures(found);
+}
 
+void Qcc::setFeatures(const std::shared_ptr<vector<Feature>>& found)
+{
+    int count[4] = { 0, 0, 0, 0 };
+    for (const Feature& feature : *found)
+        count[static_cast<int>(feature.type)]++;
+    QString info = QString("Holes: %1, Bosses: %2, Fillets: %3, Chamfers: %4")
+        .arg(count[0]).arg(count[1]).arg(count[2]).arg(count[3]);
+    myStatusBar->showMessage(info);
+}
+
+void Qcc::meshShape(bool isCustom)
+{
+    if (myQccView->getContext()->HasDetectedShape() && !meshWatcher.isRunning())
+    {
+        meshedObject = myQccView->getContext()->DetectedInteractive();
         TopoDS_Shape topoShp = myQccView->getContext()->DetectedShape();
-        Mesh mesh(topoShp);
-    
-        std::thread meshThread(&Mesh::makeTriangle, &mesh, isCustom);
-        meshThread.join();
 
-        std::thread drawThread(&Mesh::displayTriangle, &mesh);
-        drawThread.join();
-        
-        QString info = QString("Mesh Triangles: %1").arg(mesh.countTriangle());
-        myStatusBar->showMessage(info);
+        /*
+        * a whole object keeps its default mesh in the document, meshed without
+        * the pose and shown with it; a picked sub-shape does not
+        */
+        meshedId = NoObject;
+        const DocObject* anObject = document.object(document.acquire(meshedObject));
+        if (anObject && !isCustom && topoShp.IsPartner(anObject->shape))
+        {
+            if (anObject->mesh.isValid())
+            {
+                displayMesh(anObject->mesh.value, anObject->pose);
+                return;
+            }
+            meshedId = anObject->id;
+            meshedRevision = anObject->revision;
+            topoShp = anObject->shape;
+        }
+
+        /*
+        * mesh ahead of any queued batch or analysis work, meshed() shows it;
+        * the worker meshes a copy, the viewer may remesh the shown faces meanwhile
+        */
+        TopoDS_Shape aCopy = BRepBuilderAPI_Copy(topoShp, Standard_False, Standard_True).Shape();
+        meshWatcher.setFuture(TaskScheduler::instance().run([aCopy, isCustom]() {
+            std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(aCopy);
+            mesh->makeTriangle(isCustom);
+            return mesh;
+        }, TaskPriority::Interactive));
+        myStatusBar->showMessage(tr("Meshing..."));
     }
 }
 
+void Qcc::meshed()
+{
+    if (meshWatcher.isCanceled())
+        return;
+    std::shared_ptr<Mesh> mesh = meshWatcher.result();
+    const DocObject* anObject = document.object(meshedId);
+    if (!anObject)
+    {
+        displayMesh(mesh, gp_Trsf());
+        return;
+    }
+    document.attach(meshedId, meshedRevision, &DocObject::mesh, mesh);
+    displayMesh(mesh, anObject->pose);
+}
+
+void Qcc::displayMesh(const std::shared_ptr<Mesh>& mesh, const gp_Trsf& pose)
+{
+    /* erase the shape and show its triangles in one update */
+    DisplayBatch batch(myQccView);
+    myQccView->erase(meshedObject);
+    meshedObject.Nullify();
+    mesh->displayTriangle(myQccView, pose);
+
+    QString info = QString("Mesh Triangles: %1").arg(mesh->countTriangle());
+    myStatusBar->showMessage(info);
+}
+
 void Qcc::obbShape()
 {
     if (myQccView->getContext()->HasDetectedShape())
@@ -352,6 +689,16 @@ void Qcc::obbShape()
         if (topoShp.IsNull()) 
             return;
 
+        /* the box of a whole object is kept in the document, without the pose */
+        const DocObject* anObject = document.object(document.acquire(aisContext->DetectedInteractive()));
+        if (anObject && topoShp.IsPartner(anObject->shape))
+        {
+            if (!anObject->obb.isValid())
+                document.attach(anObject->id, anObject->revision, &DocObject::obb, std::make_shared<Obb>(anObject->shape));
+            anObject->obb.value->displayObb(myQccView, ObbLevel::ObbShape, anObject->pose);
+            return;
+        }
+
         Obb obbShp(topoShp);
         obbShp.displayObb(myQccView);
     }
@@ -374,27 +721,522 @@ void Qcc::load()
         filename = filename.toLower();
     }
 
-    STEPControl_Reader stepReader;  //only load English filename
-    IFSelect_ReturnStatus status = stepReader.ReadFile(filename.toLatin1().data());
-    stepReader.PrintCheckLoad(Standard_False, IFSelect_ItemsByEntity);
-    for (Standard_Integer i = 1; i <= stepReader.NbRootsForTransfer(); i++)
-        stepReader.TransferRoot(i);
- 
-    for (Standard_Integer i = 1; i <= stepReader.NbShapes(); i++)
+    if (loadWatcher.isRunning())
     {
-        currentShape = stepReader.Shape(i); 
+        myStatusBar->showMessage(tr("A load is still running"));
+        return;
     }
 
-    int count = autoDetect(currentShape);
-    QString info = QString("Face Number: %1, Edge Number: %2").arg(count).arg(edgeMap.Size());
+    /*
+    * parse, transfer and mesh on a worker, streamed() displays the pieces
+    * while they arrive and loaded() takes the whole shape
+    */
+    std::string path = filename.toUtf8().data();
+    std::shared_ptr<LoadStream> stream = std::make_shared<LoadStream>();
+    loadStream = stream;
+    streamBoxes.clear();
+    streamShapes.clear();
+    loadWatcher.setFuture(TaskScheduler::instance().run([path, stream]() {
+        std::shared_ptr<StepLoader> loader = std::make_shared<StepLoader>(path);
+        loader->setCache(true);
+        loader->setStream(stream);
+        loader->load();
+        return loader;
+    }));
+    streamTimer.start();
+    myStatusBar->showMessage(tr("Loading %1...").arg(filename));
+}
+
+void Qcc::streamed()
+{
+    if (!loadStream)
+        return;
+    vector<StreamItem> items = loadStream->take();
+    if (items.empty())
+        return;
 
-    myQccView->show(currentShape);
-    return;
+    myQccView->beginDisplay();
+    bool isFirst = streamBoxes.empty();
+    for (const StreamItem& item : items)
+    {
+        size_t id = static_cast<size_t>(item.id);
+        if (id >= streamShapes.size())
+        {
+            streamBoxes.resize(id + 1);
+            streamShapes.resize(id + 1);
+        }
+
+        switch (item.stage)
+        {
+        case StreamStage::Box:
+        {
+            Handle(AIS_Shape) aBox = new AIS_Shape(item.shape);
+            aBox->SetColor(Quantity_NOC_GRAY50);
+            myQccView->display(aBox, AIS_WireFrame, -1);  //not selectable
+            streamBoxes[id] = aBox;
+            break;
+        }
+        case StreamStage::Coarse:
+        {
+            /* a preview copy with the loader's triangulation, not selectable */
+            Handle(AIS_Shape) aPreview = new AIS_Shape(item.shape);
+            aPreview->Attributes()->SetAutoTriangulation(Standard_False);
+            myQccView->display(aPreview, -1, -1);
+            streamShapes[id] = aPreview;
+            if (!streamBoxes[id].IsNull())
+                myQccView->remove(streamBoxes[id]);
+            streamBoxes[id].Nullify();
+            break;
+        }
+        case StreamStage::Fine:
+        {
+            /* the piece itself, its mesh is final, so its selection can be prepared */
+            Handle(AIS_Shape) anAisShape = new AIS_Shape(item.shape);
+            anAisShape->Attributes()->SetAutoTriangulation(Standard_False);
+            myQccView->display(anAisShape, -1, QccView::SelectionDeferred);
+            if (!streamShapes[id].IsNull())
+                myQccView->remove(streamShapes[id]);
+            if (!streamBoxes[id].IsNull())
+                myQccView->remove(streamBoxes[id]);
+            streamBoxes[id].Nullify();
+            streamShapes[id] = anAisShape;
+            break;
+        }
+        }
+    }
+    myQccView->commitDisplay();
+    if (isFirst)
+        myQccView->fitAll();
+}
+
+void Qcc::loaded()
+{
+    streamTimer.stop();
+    streamed();
+    loadStream.reset();
+
+    /* a worker exception cancels the future */
+    if (loadWatcher.isCanceled())
+    {
+        myStatusBar->showMessage(tr("Load failed"));
+        return;
+    }
+    std::shared_ptr<StepLoader> loader = loadWatcher.result();
+    if (loader->shape().IsNull())
+    {
+        myStatusBar->showMessage(tr("Load failed, read status: %1").arg(loader->status()));
+        return;
+    }
+
+    /* the model is one object, shown by all its pieces */
+    ObjectId id = document.add(loader->shape());
+    if (loader->isStreamed())
+    {
+        for (const Handle(AIS_Shape)& anAisShape : streamShapes)
+            document.bind(id, anAisShape);
+    }
+    else
+    {
+        for (const Handle(AIS_InteractiveObject)& obj : myQccView->show(loader->shape()))
+            document.bind(id, obj);
+    }
+    if (loader->topoIndex())
+        document.attach(id, document.object(id)->revision, &DocObject::topology, loader->topoIndex());
+    document.setActive(id);
+    autoDetect(id);
+
+    const LoadTimings& t = loader->timings();
+    if (loader->isFromCache())
+        myStatusBar->showMessage(tr("Loaded from cache in %1 ms").arg(t.total(), 0, 'f', 0));
+    else
+        myStatusBar->showMessage(tr("Loaded %1 shapes in %2 ms (parse %3, transfer %4, post %5)")
+            .arg(loader->shapeCount()).arg(t.total(), 0, 'f', 0).arg(t.parse, 0, 'f', 0)
+            .arg(t.transfer, 0, 'f', 0).arg(t.post, 0, 'f', 0));
+}
+
+void Qcc::runModeling(const QString& name, const ModelingBuilder& builder)
+{
+    modeling.submit(name, builder);
+    modelBar->setValue(0);
+    modelBar->show();
+    modelTimer.start();
+    modelingProgress();
+}
+
+void Qcc::modeled(const ModelingResult& result)
+{
+    if (modeling.runningCount() == 0)
+    {
+        modelTimer.stop();
+        modelBar->hide();
+    }
+
+    if (result.isCanceled)
+    {
+        myStatusBar->showMessage(tr("%1 canceled").arg(result.name));
+        return;
+    }
+    if (!result.error.isEmpty())
+    {
+        myStatusBar->showMessage(tr("%1 failed: %2").arg(result.name).arg(result.error));
+        return;
+    }
+
+    DisplayBatch batch(myQccView);
+    for (const ModelingPart& part : result.parts)
+    {
+        Handle(AIS_Shape) anAisShape = new AIS_Shape(part.shape);
+        anAisShape->SetColor(part.color);
+        myQccView->display(anAisShape);
+        document.bind(document.add(part.shape), anAisShape);
+    }
+    QString info = tr("%1 done in %2 ms").arg(result.name).arg(result.elapsed, 0, 'f', 0);
+    if (!result.note.isEmpty())
+        info += ", " + result.note;
+    myStatusBar->showMessage(info);
+}
+
+void Qcc::modelingProgress()
+{
+    modelBar->setValue(modeling.progress());
+    myStatusBar->showMessage(tr("Modeling: %1").arg(modeling.running()));
+}
+
+void Qcc::generateModel()
+{
+    if (generateWatcher.isRunning())
+        return;
+
+    bool isOk = false;
+    GeneratorOptions options;
+    options.parts = QInputDialog::getInt(this, tr("Generate Model"), tr("Parts"), options.parts, 10, 100000, 100, &isOk);
+    if (!isOk)
+        return;
+    options.seed = static_cast<unsigned int>(QInputDialog::getInt(this, tr("Generate Model"), tr("Seed"),
+        static_cast<int>(options.seed), 0, INT_MAX, 1, &isOk));
+    if (!isOk)
+        return;
+
+    generateWatcher.setFuture(TaskScheduler::instance().run([options]() {
+        ModelGenerator generator(options);
+        TopoDS_Shape aModel = generator.assembly();
+        Handle(ObbOverlay) aSoup = new ObbOverlay(Quantity_Color(Quantity_NOC_LIGHTSKYBLUE), 0.5);
+        for (const std::array<gp_Pnt, 3>& tri : generator.triangleSoup(options.triangles, 20.0))
+            aSoup->addTriangle(tri[0], tri[1], tri[2]);
+        return std::make_pair(aModel, aSoup);
+    }));
+    myStatusBar->showMessage(tr("Generating %1 parts, seed %2...").arg(options.parts).arg(options.seed));
+}
+
+void Qcc::generated()
+{
+    if (generateWatcher.isCanceled())
+    {
+        myStatusBar->showMessage(tr("Generate failed"));
+        return;
+    }
+    std::pair<TopoDS_Shape, Handle(ObbOverlay)> result = generateWatcher.result();
+
+    {
+        DisplayBatch batch(myQccView);
+        if (!soupOverlay.IsNull())
+            myQccView->remove(soupOverlay);
+        soupOverlay = result.second;
+        myQccView->display(soupOverlay, 0, -1);  //not selectable
+    }
+
+    /* show() displays at once, after the batch is committed */
+    ObjectId id = document.add(result.first);
+    for (const Handle(AIS_InteractiveObject)& obj : myQccView->show(result.first))
+        document.bind(id, obj);
+    document.setActive(id);
+    autoDetect(id);
+    myStatusBar->showMessage(tr("Generated %1 parts and %2 triangles")
+        .arg(result.first.NbChildren()).arg(soupOverlay->triangleCount()));
+}
+
+void Qcc::loadAssembly()
+{
+    QString filename = QFileDialog::getOpenFileName(this, tr("Load Assembly"), "D:/model.stp", "*.stp *.step");
+    if (filename.isEmpty() || assemblyWatcher.isRunning() || partWatcher.isRunning())
+        return;
+
+    /* only the product structure and the boxes, assemblyRead() shows them */
+    std::string path = filename.toUtf8().data();
+    assemblyWatcher.setFuture(TaskScheduler::instance().run([path]() {
+        std::shared_ptr<AssemblyLoader> loader = std::make_shared<AssemblyLoader>(path);
+        loader->read();
+        return loader;
+    }));
+    myStatusBar->showMessage(tr("Reading assembly structure of %1...").arg(filename));
+}
+
+void Qcc::assemblyRead()
+{
+    if (assemblyWatcher.isCanceled())
+        return;
+    std::shared_ptr<AssemblyLoader> loader = assemblyWatcher.result();
+    if (loader->nodeCount() == 0)
+    {
+        myStatusBar->showMessage(tr("No assembly structure found"));
+        return;
+    }
+
+    /* drop the previous assembly */
+    myQccView->beginDisplay();
+    for (size_t i = 0; i < lazyBoxes.size(); i++)
+    {
+        if (!lazyBoxes[i].IsNull())
+        {
+            myQccView->remove(lazyBoxes[i]);
+            document.unbind(lazyBoxes[i]);
+        }
+        if (!lazyShapes[i].IsNull())
+        {
+            myQccView->instancer().release(ShapeInstancer::shapeOf(lazyShapes[i]));
+            myQccView->remove(lazyShapes[i]);
+            document.unbind(lazyShapes[i]);
+        }
+    }
+    assembly = loader;
+    lazyBoxes.assign(loader->nodeCount(), Handle(AIS_Shape)());
+    lazyShapes.assign(loader->nodeCount(), Handle(AIS_InteractiveObject)());
+    lazyNodeOf.clear();
+    lazyRequests.clear();
+
+    for (int i = 0; i < loader->nodeCount(); i++)
+    {
+        Bnd_Box aBox = loader->node(i).box;
+        if (aBox.IsVoid())
+            continue;
+        aBox.Enlarge(Precision::Confusion());
+        lazyBoxes[i] = new AIS_Shape(BRepPrimAPI_MakeBox(aBox.CornerMin(), aBox.CornerMax()).Shape());
+        lazyBoxes[i]->SetColor(Quantity_NOC_GRAY50);
+        lazyBoxes[i]->SetDisplayMode(AIS_WireFrame);
+        myQccView->display(lazyBoxes[i]);
+        lazyNodeOf[lazyBoxes[i].get()] = i;
+    }
+    myQccView->commitDisplay();
+    myQccView->fitAll();
+    myStatusBar->showMessage(tr("Assembly: %1 instances of %2 parts, structure read in %3 ms")
+        .arg(loader->nodeCount()).arg(loader->partCount()).arg(loader->readTime(), 0, 'f', 0));
+}
+
+bool Qcc::requireLazy(const Handle(AIS_InteractiveObject)& aisObj)
+{
+    /* a placeholder box asks for its part, updateLazy() schedules it */
+    std::map<const AIS_InteractiveObject*, int>::const_iterator it = lazyNodeOf.find(aisObj.get());
+    if (!assembly || it == lazyNodeOf.end() || lazyBoxes[it->second] != aisObj)
+        return false;
+
+    lazyRequests.insert(assembly->node(it->second).part);
+    updateLazy();
+    return true;
+}
+
+void Qcc::updateLazy()
+{
+    /* one batch at a time, partsLoaded() calls back here */
+    if (!assembly || partWatcher.isRunning())
+        return;
+
+    const int batchSize = 16;
+    vector<int> wanted;
+    for (int part : lazyRequests)
+    {
+        if (!assembly->isLoaded(part))
+            wanted.push_back(part);
+    }
+    lazyRequests.clear();
+
+    std::set<int> queued(wanted.begin(), wanted.end());
+    for (int i = 0; i < assembly->nodeCount() && static_cast<int>(wanted.size()) < batchSize; i++)
+    {
+        int part = assembly->node(i).part;
+        if (queued.count(part) || assembly->isLoaded(part) || !myQccView->isBoxInView(assembly->node(i).box, 8))
+            continue;
+        wanted.push_back(part);
+        queued.insert(part);
+    }
+    if (wanted.empty())
+        return;
+
+    std::shared_ptr<AssemblyLoader> loader = assembly;
+    partWatcher.setFuture(TaskScheduler::instance().run([loader, wanted]() {
+        for (int part : wanted)
+            loader->require(part);
+        return wanted;
+    }, TaskPriority::Interactive));
+    myStatusBar->showMessage(tr("Loading %1 parts...").arg(wanted.size()));
+}
+
+void Qcc::partsLoaded()
+{
+    if (!assembly || partWatcher.isCanceled())
+        return;
+
+    /* no transfer is running, the part shapes can be read directly */
+    std::set<int> loaded;
+    for (int part : partWatcher.result())
+        loaded.insert(part);
+
+    myQccView->beginDisplay();
+    std::set<int> pinned = loaded;
+    for (int i = 0; i < assembly->nodeCount(); i++)
+    {
+        const AssemblyNode& aNode = assembly->node(i);
+        if (myQccView->isBoxInView(aNode.box, 8))
+            pinned.insert(aNode.part);
+        if (!loaded.count(aNode.part) || !lazyShapes[i].IsNull() || assembly->part(aNode.part).shape.IsNull())
+            continue;
+
+        /* instances of a part share one presentation, only the transformation differs */
+        lazyShapes[i] = myQccView->instancer().instance(
+            assembly->part(aNode.part).shape.Moved(TopLoc_Location(aNode.location)));
+        myQccView->display(lazyShapes[i], -1, QccView::SelectionDeferred);
+        lazyNodeOf[lazyShapes[i].get()] = i;
+        if (!lazyBoxes[i].IsNull())
+            myQccView->erase(lazyBoxes[i]);
+    }
+
+    /* over the memory cap: parts out of view go back to their boxes */
+    vector<int> evicted = assembly->evict(pinned);
+    std::set<int> evictedSet(evicted.begin(), evicted.end());
+    for (int i = 0; i < assembly->nodeCount() && !evictedSet.empty(); i++)
+    {
+        if (!evictedSet.count(assembly->node(i).part) || lazyShapes[i].IsNull())
+            continue;
+        lazyNodeOf.erase(lazyShapes[i].get());
+        myQccView->instancer().release(ShapeInstancer::shapeOf(lazyShapes[i]));
+        myQccView->remove(lazyShapes[i]);
+        document.unbind(lazyShapes[i]);
+        lazyShapes[i].Nullify();
+        if (!lazyBoxes[i].IsNull())
+            myQccView->display(lazyBoxes[i]);
+    }
+    myQccView->commitDisplay();
+
+    myStatusBar->showMessage(tr("%1 parts loaded, %2 evicted, %3 MB in use")
+        .arg(loaded.size()).arg(evicted.size()).arg(assembly->memoryUsed() / (1024.0 * 1024.0), 0, 'f', 1));
+    updateLazy();
 }
 
 void Qcc::save()
 {
+    if (saveWatcher.isRunning())
+    {
+        myStatusBar->showMessage(tr("A save is still running"));
+        return;
+    }
+
+    QString filter = tr("STEP (*.stp *.step);;BRep (*.brep);;Binary BRep (*.bbrep)");
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save File"), "D:/model.stp", filter);
+    if (filename.isEmpty())
+        return;
+
+    if (!startSave(filename, false))
+        myStatusBar->showMessage(tr("Nothing to save"));
+}
 
+TopoDS_Shape Qcc::snapshot(vector<TopoDS_Shape>& parts) const
+{
+    /* copying the handles is enough, the worker never sees later edits */
+    parts.clear();
+    AIS_ListOfInteractive aList;
+    myQccView->getContext()->DisplayedObjects(aList);
+    for (const Handle(AIS_InteractiveObject)& anObj : aList)
+    {
+        TopoDS_Shape aShape = ShapeInstancer::shapeOf(anObj);
+        if (!aShape.IsNull())
+            parts.push_back(aShape);
+    }
+    if (parts.empty())
+        return TopoDS_Shape();
+    if (parts.size() == 1)
+        return parts.front();
+
+    TopoDS_Compound aCompound;
+    BRep_Builder aBuilder;
+    aBuilder.MakeCompound(aCompound);
+    for (const TopoDS_Shape& shp : parts)
+        aBuilder.Add(aCompound, shp);
+    return aCompound;
+}
+
+bool Qcc::startSave(const QString& fileName, bool isAuto)
+{
+    vector<TopoDS_Shape> parts;
+    TopoDS_Shape shp = snapshot(parts);
+    if (shp.IsNull())
+        return false;
+
+    std::shared_ptr<ShapeWriter> aWriter = std::make_shared<ShapeWriter>(fileName.toLocal8Bit().data(), shp);
+    writer = aWriter;
+    savedParts = parts;
+    isAutoSaving = isAuto;
+    saveWatcher.setFuture(TaskScheduler::instance().run([aWriter]() {
+        return aWriter->write();
+    }, isAuto ? TaskPriority::Background : TaskPriority::Normal));
+
+    /* auto-save stays quiet, only a user save shows the progress bar */
+    if (!isAuto)
+    {
+        saveBar->setValue(0);
+        saveBar->show();
+        progressTimer.start();
+        myStatusBar->showMessage(tr("Saving %1...").arg(fileName));
+    }
+    return true;
+}
+
+void Qcc::saveProgress()
+{
+    if (writer)
+        saveBar->setValue(writer->progress());
+}
+
+void Qcc::saved()
+{
+    progressTimer.stop();
+    saveBar->hide();
+    bool isDone = !saveWatcher.isCanceled() && saveWatcher.result();
+    QString file = QString::fromLocal8Bit(writer->file().c_str());
+
+    if (!isDone)
+        savedParts.clear();  //retry on the next auto-save
+    if (isAutoSaving)
+    {
+        if (!isDone)
+            myStatusBar->showMessage(tr("Auto-save to %1 failed").arg(file));
+    }
+    else if (isDone)
+    {
+        myStatusBar->showMessage(tr("Saved %1 in %2 ms").arg(file).arg(writer->elapsed(), 0, 'f', 0));
+    }
+    else
+    {
+        myStatusBar->showMessage(tr("Save %1 failed").arg(file));
+    }
+    writer.reset();
+}
+
+void Qcc::autoSave()
+{
+    if (saveWatcher.isRunning())
+        return;
+
+    /* skip when the same shapes are displayed as at the last save */
+    vector<TopoDS_Shape> parts;
+    snapshot(parts);
+    bool isSame = parts.size() == savedParts.size();
+    for (size_t i = 0; isSame && i < parts.size(); i++)
+        isSame = parts[i].IsEqual(savedParts[i]);
+    if (isSame)
+        return;
+
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    startSave(dir + "/autosave.bbrep", true);
 }
 
 void Qcc::makeBox()
@@ -410,7 +1252,8 @@ void Qcc::makeBox()
     Handle(AIS_Shape) anAisBox = new AIS_Shape(aTopoBox);
     anAisBox->SetColor(Quantity_NOC_CADETBLUE);
     anAisBox->SetTransparency(0.7);
-    myQccView->getContext()->Display(anAisBox, Standard_True);
+    DisplayBatch batch(myQccView);
+    myQccView->display(anAisBox);
 
 #if 0
     vector<gp_Pnt> p = Hand::geneRandTri();
@@ -422,7 +1265,7 @@ void Qcc::makeBox()
 
     Handle(AIS_Shape) anAisTri = new AIS_Shape(TopoDS_Shape(tri));
     anAisTri->SetColor(Quantity_NOC_LIGHTSKYBLUE);
-    myQccView->getContext()->Display(anAisTri, Standard_True);
+    myQccView->display(anAisTri);
 #endif
 }
 
@@ -435,14 +1278,15 @@ void Qcc::makeCone()
     Handle(AIS_Shape) anAisReducer = new AIS_Shape(aTopoReducer);
 
     anAisReducer->SetColor(Quantity_NOC_BISQUE);
-    myQccView->getContext()->Display(anAisReducer, Standard_False);
+    DisplayBatch batch(myQccView);
+    myQccView->display(anAisReducer);
 
     anAxis.SetLocation(gp_Pnt(8.0, 10.0, 0.0));
     TopoDS_Shape aTopoCone = BRepPrimAPI_MakeCone(anAxis, 3.0, 0.0, 5.0).Shape();
     Handle(AIS_Shape) anAisCone = new AIS_Shape(aTopoCone);
 
     anAisCone->SetColor(Quantity_NOC_CHOCOLATE);
-    myQccView->getContext()->Display(anAisCone, Standard_False);
+    myQccView->display(anAisCone);
 
     Handle(AIS_TextLabel) label = new AIS_TextLabel();
     std::string str("CONE");
@@ -460,8 +1304,7 @@ void Qcc::makeCone()
     label->SetPosition(label->Position().Transformed(trsfLabel));
     label->SetLocalTransformation(trsfLabel);
     label->SetZLayer(Graphic3d_ZLayerId_TopOSD);
-    myQccView->getContext()->Display(label, Standard_False);
-    myQccView->getContext()->UpdateCurrentViewer();
+    myQccView->display(label);
 }
 
 void Qcc::makeSphere()
@@ -488,8 +1331,9 @@ void Qcc::makeCylinder()
     Handle(AIS_Shape) anAisPie = new AIS_Shape(aTopoPie);
     anAisPie->SetColor(Quantity_NOC_TAN);
 
-    myQccView->getContext()->Display(anAisCylinder, Standard_True);
-    myQccView->getContext()->Display(anAisPie, Standard_True);
+    DisplayBatch batch(myQccView);
+    myQccView->display(anAisCylinder);
+    myQccView->display(anAisPie);
 }
 
 void Qcc::makeTorus()
@@ -508,8 +1352,9 @@ void Qcc::makeTorus()
 
     anAisElbow->SetColor(Quantity_NOC_THISTLE);
 
-    myQccView->getContext()->Display(anAisTorus, Standard_True);
-    myQccView->getContext()->Display(anAisElbow, Standard_True);
+    DisplayBatch batch(myQccView);
+    myQccView->display(anAisTorus);
+    myQccView->display(anAisElbow);
 }
 
 void Qcc::makeWedge()
@@ -529,7 +1374,8 @@ void Qcc::makeWedge()
     TopoDS_Shape aTopoWedge1 = BRepPrimAPI_MakeWedge(anAx2, dx, dy, dz, ltx).Shape();
     Handle(AIS_Shape) anAisWedge1 = new AIS_Shape(aTopoWedge1);
     anAisWedge1->SetColor(Quantity_NOC_YELLOW);
-    myQccView->getContext()->Display(anAisWedge1, Standard_True);
+    DisplayBatch batch(myQccView);
+    myQccView->display(anAisWedge1);
 
     /* Second Wedge method: anAx2, dx, dy, dz, xmin, xmax, zmix, zmax */
     anAx2.SetLocation(gp_Pnt(0.0, 0.0, 0.0));
@@ -553,7 +1399,7 @@ void Qcc::makeWedge()
     TopoDS_Shape sheet = BRepAlgoAPI_Fuse(sheet1, sheet2);
     Handle(AIS_Shape) anAisSheet = new AIS_Shape(sheet);
     anAisSheet->SetColor(Quantity_NOC_YELLOW4);
-    myQccView->getContext()->Display(anAisSheet, Standard_True);
+    myQccView->display(anAisSheet);
 }
 
 void Qcc::makeHollow()
@@ -575,8 +1421,9 @@ void Qcc::makeHollow()
 
     aAisRevolVertex->SetColor(Quantity_NOC_LIMEGREEN);
     bAisRevolVertex->SetColor(Quantity_NOC_LIMEGREEN);
-    myQccView->getContext()->Display(aAisRevolVertex, Standard_True);
-    myQccView->getContext()->Display(bAisRevolVertex, Standard_True);
+    DisplayBatch batch(myQccView);
+    myQccView->display(aAisRevolVertex);
+    myQccView->display(bAisRevolVertex);
 
     // prism a vertex result is an straight edge
     TopoDS_Vertex cVertex = BRepBuilderAPI_MakeVertex(gp_Pnt(6.0, 6.0+ra, 1.5));
@@ -584,7 +1431,7 @@ void Qcc::makeHollow()
     Handle(AIS_Shape) anAisPrismVertex = new AIS_Shape(aPrismVertex);
     
     anAisPrismVertex->SetColor(Quantity_NOC_LIMEGREEN);
-    myQccView->getContext()->Display(anAisPrismVertex, Standard_True);
+    myQccView->display(anAisPrismVertex);
 
     // revol an edge result is a circle face and extrude it to a solid
     TopoDS_Edge anRadius = BRepBuilderAPI_MakeEdge(gp_Pnt(ra + 6.0, 6.0, 1.5), gp_Pnt(rb + 6.0, 6.0, 1.5));
@@ -596,49 +1443,51 @@ void Qcc::makeHollow()
     Handle(AIS_Shape) anAisSolid = new AIS_Shape(extrudeSolid);
     anAisRadius->SetColor(Quantity_NOC_LIMEGREEN);
     anAisSolid->SetColor(Quantity_NOC_LIMEGREEN);
-    myQccView->getContext()->Display(anAisRadius, Standard_True);
-    myQccView->getContext()->Display(anAisSolid, Standard_True);
+    myQccView->display(anAisRadius);
+    myQccView->display(anAisSolid);
 }
 
 void Qcc::makeFillet()
 {
-    gp_Ax2 anAxis;
-    anAxis.SetLocation(gp_Pnt(0.0, 50.0, 0.0));
+    runModeling(tr("Fillet"), [](const Message_ProgressRange& theRange, QString&) {
+        gp_Ax2 anAxis;
+        anAxis.SetLocation(gp_Pnt(0.0, 50.0, 0.0));
 
-    TopoDS_Shape aTopoBox = BRepPrimAPI_MakeBox(anAxis, 3.0, 4.0, 5.0).Shape();
-    BRepFilletAPI_MakeFillet MF(aTopoBox);
+        TopoDS_Shape aTopoBox = BRepPrimAPI_MakeBox(anAxis, 3.0, 4.0, 5.0).Shape();
+        BRepFilletAPI_MakeFillet MF(aTopoBox);
 
-    for (TopExp_Explorer ex(aTopoBox, TopAbs_EDGE); ex.More(); ex.Next())
-    {
-        MF.Add(1.0, TopoDS::Edge(ex.Current()));
-    }
+        for (TopExp_Explorer ex(aTopoBox, TopAbs_EDGE); ex.More(); ex.Next())
+        {
+            MF.Add(1.0, TopoDS::Edge(ex.Current()));
+        }
 
-    Handle(AIS_Shape) anAisShape = new AIS_Shape(MF.Shape());
-    anAisShape->SetColor(Quantity_NOC_VIOLET);
-    myQccView->getContext()->Display(anAisShape, Standard_True);
+        MF.Build(theRange);
+        return vector<ModelingPart>{ { MF.Shape(), Quantity_NOC_VIOLET } };
+    });
 }
 
 void Qcc::makeChamfer()
 {
-    gp_Ax2 anAxis;
-    anAxis.SetLocation(gp_Pnt(8.0, 5.0, 0.0));
+    runModeling(tr("Chamfer"), [](const Message_ProgressRange& theRange, QString&) {
+        gp_Ax2 anAxis;
+        anAxis.SetLocation(gp_Pnt(8.0, 5.0, 0.0));
 
-    TopoDS_Shape aTopoBox = BRepPrimAPI_MakeBox(anAxis, 3.0, 4.0, 5.0).Shape();
-    BRepFilletAPI_MakeChamfer MC(aTopoBox);
-    
-    TopTools_IndexedDataMapOfShapeListOfShape aEdgeFaceMap;
-    TopExp::MapShapesAndAncestors(aTopoBox, TopAbs_EDGE, TopAbs_FACE, aEdgeFaceMap);
+        TopoDS_Shape aTopoBox = BRepPrimAPI_MakeBox(anAxis, 3.0, 4.0, 5.0).Shape();
+        BRepFilletAPI_MakeChamfer MC(aTopoBox);
 
-    for (Standard_Integer i = 1; i <= aEdgeFaceMap.Extent(); ++i)
-    {
-        TopoDS_Edge anEdge = TopoDS::Edge(aEdgeFaceMap.FindKey(i));
-        TopoDS_Face aFace = TopoDS::Face(aEdgeFaceMap.FindFromIndex(i).First());
-        MC.Add(0.6, 0.6, anEdge, aFace);
-    }
+        TopTools_IndexedDataMapOfShapeListOfShape aEdgeFaceMap;
+        TopExp::MapShapesAndAncestors(aTopoBox, TopAbs_EDGE, TopAbs_FACE, aEdgeFaceMap);
 
-    Handle(AIS_Shape) anAisShape = new AIS_Shape(MC.Shape());
-    anAisShape->SetColor(Quantity_NOC_TOMATO);
-    myQccView->getContext()->Display(anAisShape, Standard_True);
+        for (Standard_Integer i = 1; i <= aEdgeFaceMap.Extent(); ++i)
+        {
+            TopoDS_Edge anEdge = TopoDS::Edge(aEdgeFaceMap.FindKey(i));
+            TopoDS_Face aFace = TopoDS::Face(aEdgeFaceMap.FindFromIndex(i).First());
+            MC.Add(0.6, 0.6, anEdge, aFace);
+        }
+
+        MC.Build(theRange);
+        return vector<ModelingPart>{ { MC.Shape(), Quantity_NOC_TOMATO } };
+    });
 }
 
 void Qcc::makeExtrude()
@@ -675,10 +1524,11 @@ void Qcc::makeExtrude()
     anAisPrismCircle->SetColor(Quantity_NOC_PERU);
     anAisPrismEllipse->SetColor(Quantity_NOC_PINK);
 
-    myQccView->getContext()->Display(anAisPrismVertex, Standard_True);
-    myQccView->getContext()->Display(anAisPrismEdge, Standard_True);
-    myQccView->getContext()->Display(anAisPrismCircle, Standard_True);
-    myQccView->getContext()->Display(anAisPrismEllipse, Standard_True);
+    DisplayBatch batch(myQccView);
+    myQccView->display(anAisPrismVertex);
+    myQccView->display(anAisPrismEdge);
+    myQccView->display(anAisPrismCircle);
+    myQccView->display(anAisPrismEllipse);
 }
 
 void Qcc::makeRevol()
@@ -721,48 +1571,49 @@ void Qcc::makeRevol()
     anAisRevolCircle->SetColor(Quantity_NOC_MAGENTA1);
     anAisRevolEllipse->SetColor(Quantity_NOC_MAROON);
 
-    myQccView->getContext()->Display(anAisRevolVertex, Standard_True);
-    myQccView->getContext()->Display(anAisRevolEdge, Standard_True);
-    myQccView->getContext()->Display(anAisRevolCircle, Standard_True);
-    myQccView->getContext()->Display(anAisRevolEllipse, Standard_True);
+    DisplayBatch batch(myQccView);
+    myQccView->display(anAisRevolVertex);
+    myQccView->display(anAisRevolEdge);
+    myQccView->display(anAisRevolCircle);
+    myQccView->display(anAisRevolEllipse);
 }
 
 void Qcc::makeLoft()
 {
-    // bottom wire.
-    TopoDS_Edge aCircleEdge = BRepBuilderAPI_MakeEdge(gp_Circ(gp_Ax2(gp_Pnt(0.0, 80.0, 0.0), gp::DZ()), 1.5));
-    TopoDS_Wire aCircleWire = BRepBuilderAPI_MakeWire(aCircleEdge);
-
-    // top wire.
-    BRepBuilderAPI_MakePolygon aPolygon;
-    aPolygon.Add(gp_Pnt(-3.0, 77.0, 6.0));
-    aPolygon.Add(gp_Pnt(3.0, 77.0, 6.0));
-    aPolygon.Add(gp_Pnt(3.0, 83.0, 6.0));
-    aPolygon.Add(gp_Pnt(-3.0, 83.0, 6.0));
-    aPolygon.Close();
-
-    BRepOffsetAPI_ThruSections aShellGenerator;
-    BRepOffsetAPI_ThruSections aSolidGenerator(true);
-
-    aShellGenerator.AddWire(aCircleWire);
-    aShellGenerator.AddWire(aPolygon.Wire());
-
-    aSolidGenerator.AddWire(aCircleWire);
-    aSolidGenerator.AddWire(aPolygon.Wire());
-
-    // translate the solid.
-    gp_Trsf aTrsf;
-    aTrsf.SetTranslation(gp_Vec(18.0, 0.0, 0.0));
-    BRepBuilderAPI_Transform aTransform(aSolidGenerator.Shape(), aTrsf);
-
-    Handle(AIS_Shape) anAisShell = new AIS_Shape(aShellGenerator.Shape());
-    Handle(AIS_Shape) anAisSolid = new AIS_Shape(aTransform.Shape());
-
-    anAisShell->SetColor(Quantity_NOC_OLIVEDRAB);
-    anAisSolid->SetColor(Quantity_NOC_PEACHPUFF);
-
-    myQccView->getContext()->Display(anAisShell, Standard_True);
-    myQccView->getContext()->Display(anAisSolid, Standard_True);
+    runModeling(tr("Loft"), [](const Message_ProgressRange& theRange, QString&) {
+        // bottom wire.
+        TopoDS_Edge aCircleEdge = BRepBuilderAPI_MakeEdge(gp_Circ(gp_Ax2(gp_Pnt(0.0, 80.0, 0.0), gp::DZ()), 1.5));
+        TopoDS_Wire aCircleWire = BRepBuilderAPI_MakeWire(aCircleEdge);
+
+        // top wire.
+        BRepBuilderAPI_MakePolygon aPolygon;
+        aPolygon.Add(gp_Pnt(-3.0, 77.0, 6.0));
+        aPolygon.Add(gp_Pnt(3.0, 77.0, 6.0));
+        aPolygon.Add(gp_Pnt(3.0, 83.0, 6.0));
+        aPolygon.Add(gp_Pnt(-3.0, 83.0, 6.0));
+        aPolygon.Close();
+
+        BRepOffsetAPI_ThruSections aShellGenerator;
+        BRepOffsetAPI_ThruSections aSolidGenerator(true);
+
+        aShellGenerator.AddWire(aCircleWire);
+        aShellGenerator.AddWire(aPolygon.Wire());
+
+        aSolidGenerator.AddWire(aCircleWire);
+        aSolidGenerator.AddWire(aPolygon.Wire());
+
+        Message_ProgressScope aScope(theRange, "Loft", 2);
+        aShellGenerator.Build(aScope.Next());
+        aSolidGenerator.Build(aScope.Next());
+
+        // translate the solid.
+        gp_Trsf aTrsf;
+        aTrsf.SetTranslation(gp_Vec(18.0, 0.0, 0.0));
+        BRepBuilderAPI_Transform aTransform(aSolidGenerator.Shape(), aTrsf);
+
+        return vector<ModelingPart>{ { aShellGenerator.Shape(), Quantity_NOC_OLIVEDRAB },
+            { aTransform.Shape(), Quantity_NOC_PEACHPUFF } };
+    });
 }
 
 void Qcc::testCut()
@@ -783,34 +1634,48 @@ void Qcc::testCut()
     Handle(AIS_Shape) anAisBox = new AIS_Shape(aTopoBox);
     anAisCylinder->SetColor(Quantity_NOC_BEIGE);
     anAisBox->SetColor(Quantity_NOC_BEET);
-    myQccView->getContext()->Display(anAisCylinder, Standard_True);
-    myQccView->getContext()->Display(anAisBox, Standard_True);
-
-    gp_Trsf aTrsf;
-    TopoDS_Shape aTopoHole;
-    /* Box cut Cylinder at (gap, gap, 0) */
-    aTopoHole = BRepAlgoAPI_Cut(aTopoBox, aTopoCylinder);
-
-    /* Box cut Cylinder at (width - gap, gap, 0)*/
-    aTrsf.SetTranslation(gp_Vec(width - 2 * gap, 0.0, 0.0));
-    BRepBuilderAPI_Transform aBRepTrsf1(aTopoCylinder, aTrsf);
-    aTopoHole = BRepAlgoAPI_Cut(aTopoHole, aBRepTrsf1.Shape());
-
-    /* Box cut Cylinder at (width - gap, width - gap, 0) */
-    aTrsf.SetTranslation(gp_Vec(width - 2 * gap, width - 2 * gap, 0.0));
-    BRepBuilderAPI_Transform aBRepTrsf2(aTopoCylinder, aTrsf);
-    aTopoHole = BRepAlgoAPI_Cut(aTopoHole, aBRepTrsf2.Shape());
+    DisplayBatch batch(myQccView);
+    myQccView->display(anAisCylinder);
+    myQccView->display(anAisBox);
+
+    /* the job cuts copies, the viewer tessellates the shown faces meanwhile */
+    TopoDS_Shape aBoxCopy = BRepBuilderAPI_Copy(aTopoBox, Standard_False, Standard_False).Shape();
+    TopoDS_Shape aCylinderCopy = BRepBuilderAPI_Copy(aTopoCylinder, Standard_False, Standard_False).Shape();
+
+    /* Box cut Cylinders at (gap, gap, 0), (width - gap, gap, 0), (width - gap, width - gap, 0), (gap, width - gap, 0) */
+    vector<TopoDS_Shape> aTools;
+    const gp_Vec aSteps[4] = { gp_Vec(0.0, 0.0, 0.0), gp_Vec(width - 2 * gap, 0.0, 0.0),
+        gp_Vec(width - 2 * gap, width - 2 * gap, 0.0), gp_Vec(0.0, width - 2 * gap, 0.0) };
+    for (const gp_Vec& aStep : aSteps)
+    {
+        gp_Trsf aTrsf;
+        aTrsf.SetTranslation(aStep);
+        aTools.push_back(aCylinderCopy.Moved(TopLoc_Location(aTrsf)));
+    }
 
-    /* Box cut Cylinder at (gap, width - gap, 0) */
-    aTrsf.SetTranslation(gp_Vec(0.0, width - 2 * gap, 0.0));
-    BRepBuilderAPI_Transform aBRepTrsf3(aTopoCylinder, aTrsf);
-    aTopoHole = BRepAlgoAPI_Cut(aTopoHole, aBRepTrsf3.Shape());
+    /* the tools and the box are shown at once, the holes come back from the job */
+    /* the chained cuts only run to compare the time, while tracing */
+    const bool toCompare = Tracer::isEnabled();
+    runModeling(tr("Cut"), [aBoxCopy, aTools, width, toCompare](const Message_ProgressRange& theRange, QString& note) {
+        /* all holes in one pass */
+        Message_ProgressScope aScope(theRange, "Cut", toCompare ? 2 : 1);
+        MultiCut aCut(aBoxCopy, aTools);
+        if (!aCut.perform(aScope.Next()))
+            throw std::runtime_error("the boolean failed");
+        if (toCompare)
+        {
+            MultiCut aChained(aBoxCopy, aTools);
+            if (aChained.performChained(aScope.Next()))
+                note = QString("%1 tools in one pass %2 ms, chained %3 ms").arg(static_cast<int>(aTools.size()))
+                    .arg(aCut.elapsed(), 0, 'f', 1).arg(aChained.elapsed(), 0, 'f', 1);
+        }
+        TopoDS_Shape aTopoHole = aCut.shape();
 
-    aTrsf.SetTranslation(gp_Vec(width * 1.5, 0.0, 0.0));
-    BRepBuilderAPI_Transform aBRepTrsfHole(aTopoHole, aTrsf);
-    Handle(AIS_Shape) anAisHole = new AIS_Shape(aBRepTrsfHole.Shape());
-    anAisHole->SetColor(Quantity_NOC_CHOCOLATE);
-    myQccView->getContext()->Display(anAisHole, Standard_True);
+        gp_Trsf aTrsf;
+        aTrsf.SetTranslation(gp_Vec(width * 1.5, 0.0, 0.0));
+        BRepBuilderAPI_Transform aBRepTrsfHole(aTopoHole, aTrsf);
+        return vector<ModelingPart>{ { aBRepTrsfHole.Shape(), Quantity_NOC_CHOCOLATE } };
+    });
 }
 
 void Qcc::testHelix()
@@ -840,40 +1705,53 @@ void Qcc::makeCylindericalHelix()
     Handle(AIS_Shape) anAisHelixCurve = new AIS_Shape(aTransform.Shape());
     Handle(AIS_Shape) anAisHelixEdge = new AIS_Shape(aHelixEdge);
 
-    myQccView->getContext()->Display(anAisHelixCurve, Standard_True);
-    myQccView->getContext()->Display(anAisHelixEdge, Standard_True);
+    DisplayBatch batch(myQccView);
+    myQccView->display(anAisHelixCurve);
+    myQccView->display(anAisHelixEdge);
 
     // sweep a circle profile along the helix curve.
     // there is no curve3d in the pcurve edge, so approx one.
+    // the edge is shown already, it is only changed here and never on the worker,
+    // which sweeps along a copy: the viewer tessellates the shown edge meanwhile.
     BRepLib::BuildCurve3d(aHelixEdge);
+    TopoDS_Edge aHelixCopy = TopoDS::Edge(BRepBuilderAPI_Copy(aHelixEdge, Standard_False, Standard_False).Shape());
 
-    gp_Ax2 anAxis;
-    anAxis.SetDirection(gp_Dir(0.0, 4.0, 1.0));
-    anAxis.SetLocation(gp_Pnt(aRadius, 0.0, 0.0));
+    runModeling(tr("Sweep"), [aHelixCopy, aRadius](const Message_ProgressRange& theRange, QString&) {
+        /* the pipe algorithm has no progress of its own, abort is checked around it */
+        Message_ProgressScope aScope(theRange, "Sweep", 1);
+        gp_Ax2 anAxis;
+        anAxis.SetDirection(gp_Dir(0.0, 4.0, 1.0));
+        anAxis.SetLocation(gp_Pnt(aRadius, 0.0, 0.0));
 
-    gp_Circ aProfileCircle(anAxis, 0.3);
+        gp_Circ aProfileCircle(anAxis, 0.3);
 
-    TopoDS_Edge aProfileEdge = BRepBuilderAPI_MakeEdge(aProfileCircle).Edge();
-    TopoDS_Wire aProfileWire = BRepBuilderAPI_MakeWire(aProfileEdge).Wire();
-    TopoDS_Face aProfileFace = BRepBuilderAPI_MakeFace(aProfileWire).Face();
+        TopoDS_Edge aProfileEdge = BRepBuilderAPI_MakeEdge(aProfileCircle).Edge();
+        TopoDS_Wire aProfileWire = BRepBuilderAPI_MakeWire(aProfileEdge).Wire();
+        TopoDS_Face aProfileFace = BRepBuilderAPI_MakeFace(aProfileWire).Face();
 
-    TopoDS_Wire aHelixWire = BRepBuilderAPI_MakeWire(aHelixEdge).Wire();
+        TopoDS_Wire aHelixWire = BRepBuilderAPI_MakeWire(aHelixCopy).Wire();
 
-    BRepOffsetAPI_MakePipe aPipeMaker(aHelixWire, aProfileFace);
+        vector<ModelingPart> parts;
+        if (!aScope.More())
+            return parts;
+        BRepOffsetAPI_MakePipe aPipeMaker(aHelixWire, aProfileFace);
+        aScope.Next();
 
-    if (aPipeMaker.IsDone())
-    {
-        aTrsf.SetTranslation(gp_Vec(8.0, 120.0, 0.0));
-        BRepBuilderAPI_Transform aPipeTransform(aPipeMaker.Shape(), aTrsf);
-
-        Handle(AIS_Shape) anAisPipe = new AIS_Shape(aPipeTransform.Shape());
-        anAisPipe->SetColor(Quantity_NOC_CORAL);
-        myQccView->getContext()->Display(anAisPipe, Standard_True);
-    }
+        if (aPipeMaker.IsDone())
+        {
+            gp_Trsf aTrsf;
+            aTrsf.SetTranslation(gp_Vec(8.0, 120.0, 0.0));
+            BRepBuilderAPI_Transform aPipeTransform(aPipeMaker.Shape(), aTrsf);
+            parts.push_back({ aPipeTransform.Shape(), Quantity_NOC_CORAL });
+        }
+        return parts;
+    });
 }
 
 void Qcc::makeFaceHole()
 {
+    DisplayBatch batch(myQccView);
+
     Standard_Real gap = 2.0;
     Standard_Real radius = 1.0;
     Standard_Real width = 12.0;
@@ -931,12 +1809,12 @@ void Qcc::makeFaceHole()
         TopoDS_Shape aTopoFace = aFaceMaker.Shape();
         // BRepTools::Write(aTopoFace, "D:/face.brep");
         Handle(AIS_Shape) anAisFace = new AIS_Shape(aTopoFace);
-        myQccView->getContext()->Display(anAisFace, Standard_True);
+        myQccView->display(anAisFace);
     }
 
     TopoDS_Shape aTopoHole = BRepPrimAPI_MakePrism(aFaceMaker.Face(), gp_Vec(0.0, 0.0, height));
     Handle(AIS_Shape) anAisHole = new AIS_Shape(aTopoHole);
-    myQccView->getContext()->Display(anAisHole, Standard_True);
+    myQccView->display(anAisHole);
 }
 
 void Qcc::deleteShape()
@@ -944,20 +1822,24 @@ void Qcc::deleteShape()
     if (myQccView->getContext()->HasDetectedShape())
     {
         Handle(AIS_InteractiveObject) aisObj = myQccView->getContext()->DetectedInteractive();
-        myQccView->getContext()->Erase(aisObj, Standard_True);
+        DisplayBatch batch(myQccView);
+        myQccView->erase(aisObj);
+        document.unbind(aisObj);
     }
 }
 
 void Qcc::selectShape()
 {
-    selectedShape.clear();
+    vector<TopoDS_Shape> picked;
     const Handle(AIS_Selection) selection = myQccView->getSelection();
     for (selection->Init(); selection->More(); selection->Next())
     {
         Handle(SelectMgr_EntityOwner) entity = selection->Value();
-        TopoDS_Shape shp = Handle(StdSelect_BRepOwner)::DownCast(entity)->Shape();
-        selectedShape.push_back(shp);
+        Handle(AIS_InteractiveObject) aisObj = Handle(AIS_InteractiveObject)::DownCast(entity->Selectable());
+        Handle(StdSelect_BRepOwner) brepOwner = Handle(StdSelect_BRepOwner)::DownCast(entity);
+        if (requireLazy(aisObj) || brepOwner.IsNull())
+            continue;  //placeholder box or manipulator part
+        picked.push_back(brepOwner->Shape());
     }
+    document.setSelection(picked);
 }
-
-Handle(AIS_InteractiveContext) glbContext = NULL;
\ No newline at end of file
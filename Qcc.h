@@ -3,9 +3,14 @@
 #include <iostream>
 #include <vector>
 #include <set>
+#include <map>
 #include <QMainWindow>
 #include <QException>
 #include <QDebug>
+#include <QFutureWatcher>
+#include <QProgressBar>
+#include <QTimer>
+#include <memory>
 
 #include <gp_Circ.hxx>
 #include <gp_Elips.hxx>
@@ -61,9 +66,22 @@
 #include <BRepBndLib.hxx>
 
 #include "ui_Qcc.h"
+#include "TopoIndex.h"
+#include "FaceTable.h"
+#include "Feature.h"
+#include "StepLoader.h"
+#include "ShapeWriter.h"
+#include "AssemblyLoader.h"
+#include "TaskScheduler.h"
+#include "ModelGenerator.h"
+#include "ObbOverlay.h"
+#include "Document.h"
+#include "ModelingQueue.h"
 
 using std::vector;
 
+class Mesh;
+
 namespace Ui {
     class QccClass;
 }
@@ -93,6 +111,19 @@ protected:
     void createStatusBar(void);
 
     void makeCylindericalHelix(void);
+    bool requireLazy(const Handle(AIS_InteractiveObject)& aisObj);
+
+    TopoDS_Shape snapshot(vector<TopoDS_Shape>& parts) const;
+    bool startSave(const QString& fileName, bool isAuto);
+
+    /* the analysis chain, each step takes the document's artifact when it is valid */
+    void setFaceTable(const std::shared_ptr<FaceTable>& table);
+    void setFeatures(const std::shared_ptr<vector<Feature>>& found);
+    void displayMesh(const std::shared_ptr<Mesh>& mesh, const gp_Trsf& pose);
+
+    /* queue a modeling job, modeled() takes it back on the ui thread */
+    void runModeling(const QString& name, const ModelingBuilder& builder);
+    void modeled(const ModelingResult& result);
 
 private slots:
     /* Help */
@@ -123,19 +154,84 @@ private slots:
     void obbShape(void);
     void anlsShape(void);
     void meshShape(bool);
+    void meshed(void);
     void deleteShape(void);
     void selectShape(void);
-    int autoDetect(const TopoDS_Shape&);
+    void loaded(void);
+    void autoDetect(ObjectId);
+    void topoIndexed(void);
+    void setTopoIndex(const std::shared_ptr<TopoIndex>&);
+    void faceClassified(void);
+    void propertiesComputed(void);
+    void moved(const Handle(AIS_InteractiveObject)&);
+    void featureRecognized(void);
+    void saved(void);
+    void autoSave(void);
+    void saveProgress(void);
+    void streamed(void);
+    void loadAssembly(void);
+    void assemblyRead(void);
+    void updateLazy(void);
+    void partsLoaded(void);
+    void modelingProgress(void);
+    void generateModel(void);
+    void generated(void);
 
 private:
     Ui::QccClass *ui;
     QccView* myQccView;
     QStatusBar* myStatusBar;
 
-    std::vector<TopoDS_Shape> selectedShape;
-    TopoDS_Shape currentShape;
-    TopTools_IndexedDataMapOfShapeListOfShape edgeFaceMap;
-    TopTools_IndexedMapOfShape edgeMap;
+    /* objects on screen and what is derived from them */
+    Document document;
+    QFutureWatcher<std::shared_ptr<StepLoader>> loadWatcher;
+
+    /* streamed load: pieces are displayed as the loader pushes them */
+    std::shared_ptr<LoadStream> loadStream;
+    QTimer streamTimer;
+    vector<Handle(AIS_Shape)> streamBoxes;
+    vector<Handle(AIS_Shape)> streamShapes;
+
+    /* lazy assembly: a box per instance until its part is required */
+    std::shared_ptr<AssemblyLoader> assembly;
+    QFutureWatcher<std::shared_ptr<AssemblyLoader>> assemblyWatcher;
+    QFutureWatcher<vector<int>> partWatcher;
+    QTimer lazyTimer;
+    vector<Handle(AIS_Shape)> lazyBoxes;
+    vector<Handle(AIS_InteractiveObject)> lazyShapes;
+    std::map<const AIS_InteractiveObject*, int> lazyNodeOf;
+    std::set<int> lazyRequests;
+    /* mesh of the picked shape, meshed() swaps it in for the shape */
+    QFutureWatcher<std::shared_ptr<Mesh>> meshWatcher;
+    Handle(AIS_InteractiveObject) meshedObject;
+    ObjectId meshedId;            //NoObject when a sub-shape was meshed
+    unsigned int meshedRevision;
+
+    /* analysis of the active object, cancelled when another one is picked */
+    CancelToken analysisToken;
+    ObjectId analysisId;
+    unsigned int analysisRevision;
+    QFutureWatcher<std::shared_ptr<TopoIndex>> topoWatcher;
+    QFutureWatcher<std::shared_ptr<ShapeProperties>> propsWatcher;
+    QFutureWatcher<std::shared_ptr<FaceTable>> faceWatcher;
+    QFutureWatcher<std::shared_ptr<vector<Feature>>> featureWatcher;
+
+    /* save runs on a worker, the ui polls the writer for progress */
+    std::shared_ptr<ShapeWriter> writer;
+    QFutureWatcher<bool> saveWatcher;
+    QProgressBar* saveBar;
+    QTimer progressTimer;
+    QTimer autoSaveTimer;
+    bool isAutoSaving;
+    vector<TopoDS_Shape> savedParts;
+
+    /* seeded stress model and its triangle soup, built on a worker */
+    QFutureWatcher<std::pair<TopoDS_Shape, Handle(ObbOverlay)>> generateWatcher;
+    Handle(ObbOverlay) soupOverlay;
+
+    /* fillet, chamfer, boolean, sweep and loft run as jobs, their parts come back to modeled() */
+    ModelingQueue modeling;
+    QProgressBar* modelBar;
+    QTimer modelTimer;
 };
 
-extern Handle(AIS_InteractiveContext) glbContext;
@@ -1,17 +1,49 @@
 #include "Qcc.h"
 #include "QccView.h"
+#include "TaskScheduler.h"
 #include <OpenGl_GraphicDriver.hxx>
+#include <OpenGl_Context.hxx>
+#include <OpenGl_FrameBuffer.hxx>
 
 #include <QMenu>
 #include <QMouseEvent>
 #include <QRubberBand>
 #include <QStyleFactory>
+#include <QFile>
+#include <QSurfaceFormat>
+#include <QJsonDocument>
+#include <climits>
+#include <set>
+#include <algorithm>
 
 #include <Aspect_Handle.hxx>
 #include <Aspect_DisplayConnection.hxx>
+#include <Graphic3d_TransformPers.hxx>
+#include <BRep_Tool.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <AIS_ConnectedInteractive.hxx>
+#include <StdSelect_ViewerSelector3d.hxx>
+
+/* triangles an object draws, an instance counts those of its reference */
+static int triangleCount(const Handle(AIS_InteractiveObject)& obj)
+{
+	TopoDS_Shape aShape = ShapeInstancer::shapeOf(obj);
+	if (aShape.IsNull())
+		return 0;
+	int nbTriangles = 0;
+	for (TopExp_Explorer exp(aShape, TopAbs_FACE); exp.More(); exp.Next())
+	{
+		TopLoc_Location aLoc;
+		Handle(Poly_Triangulation) triMesh = BRep_Tool::Triangulation(TopoDS::Face(exp.Current()), aLoc);
+		if (!triMesh.IsNull())
+			nbTriangles += triMesh->NbTriangles();
+	}
+	return nbTriangles;
+}
 
 QccView::QccView(QWidget* parent)
-	: QGLWidget(parent),
+	: QOpenGLWidget(parent),
 	myXmin(0),
 	myYmin(0),
 	myXmax(0),
@@ -19,19 +51,54 @@ QccView::QccView(QWidget* parent)
 	myCurrentMode(CurrentAction3d::CurAction3d_DynamicRotation),
 	myDegenerateModeIsOn(Standard_True),
 	myRectBand(NULL),
-	myManipulator(NULL)
+	myManipulator(NULL),
+	myScheduler(NULL),
+	myIsPreviewOn(false),
+	myIsPreviewed(false),
+	myDisplayDepth(0),
+	myPreparingMode(-1)
 {
 	setBackgroundRole(QPalette::NoRole);
 	/* set focus policy to threat QContextMenuEvent from keyboard */
 	setFocusPolicy(Qt::StrongFocus);
-	setAttribute(Qt::WA_PaintOnScreen);
-	setAttribute(Qt::WA_NoSystemBackground);
 	/* enable the mouse tracking, by default the mouse tracking is disable */
 	setMouseTracking(true);
 
+	/* occt needs the compatibility profile and a stencil buffer */
+	QSurfaceFormat aGlFormat;
+	aGlFormat.setDepthBufferSize(24);
+	aGlFormat.setStencilBufferSize(8);
+	aGlFormat.setProfile(QSurfaceFormat::CompatibilityProfile);
+	setFormat(aGlFormat);
+
+	/* every redraw request goes through the scheduler, idle means no frame */
+	myScheduler = new FrameScheduler(this);
 	initContext();
 	mySelectMode = -1;	//default mode
 	myManipulator = new AIS_Manipulator();
+
+	/* mouse moves only record the position, hover() picks once per frame */
+	myHoverTimer.setSingleShot(true);
+	myHoverTimer.setInterval(16);
+	connect(&myHoverTimer, &QTimer::timeout, this, &QccView::hover);
+
+	/* rectangle selection runs on release, the preview is optional */
+	myPreviewTimer.setSingleShot(true);
+	myPreviewTimer.setInterval(100);
+	connect(&myPreviewTimer, &QTimer::timeout, this, &QccView::previewSelection);
+
+	myStatsTimer.setInterval(1000);
+	connect(&myStatsTimer, &QTimer::timeout, this, &QccView::statsTick);
+
+	connect(&mySelectionWatcher, &QFutureWatcher<void>::finished, this, &QccView::selectionPrepared);
+}
+
+QccView::~QccView()
+{
+	/* the view's gl resources are released with the widget's context current */
+	makeCurrent();
+	myView->Remove();
+	doneCurrent();
 }
 
 void QccView::initContext() 
@@ -40,16 +107,13 @@ void QccView::initContext()
 	{
 		Handle(Aspect_DisplayConnection) aDisplayConnection = new Aspect_DisplayConnection();
 		
+		/* no context of its own, initializeGL() hands over the widget's one */
 		if (myDriver.IsNull())
-			myDriver = new OpenGl_GraphicDriver(aDisplayConnection);
-
-		WId window_handle = (WId)winId();
-
-#ifdef _WIN32
-		Handle(WNT_Window) wind = new WNT_Window((Aspect_Handle)window_handle);
-#else
-		Handle(Xw_Window) wind = new Xw_Window(aDisplayConnection, (Window)window_handle);
-#endif
+		{
+			Handle(OpenGl_GraphicDriver) aDriver = new OpenGl_GraphicDriver(aDisplayConnection, Standard_False);
+			aDriver->ChangeOptions().buffersNoSwap = Standard_True;
+			myDriver = aDriver;
+		}
 
 		myViewer = new V3d_Viewer(myDriver);
 		myContext = new AIS_InteractiveContext(myViewer);
@@ -58,22 +122,72 @@ void QccView::initContext()
 		myViewer->SetLightOn();
 
 		myContext->SetDisplayMode(AIS_Shaded, Standard_True);
+		/* selection BVHs are built by the selector's own threads, not on the first pick */
+		myContext->MainSelector()->SetToPrebuildBVH(Standard_True);
 
-		myView = myViewer->CreateView();
-		myView->SetWindow(wind);
-		if (!wind->IsMapped())
-		{
-			wind->Map();
-		}
-
+		myView = new FrameView(myViewer, myScheduler);
 		myView->SetBackgroundColor(Quantity_NOC_BLACK);
-		myView->MustBeResized();
 		myView->TriedronDisplay(Aspect_TOTP_LEFT_LOWER, Quantity_NOC_GOLD, 0.08, V3d_ZBUFFER);
 	}
 
 	myContext->SetPixelTolerance(1);
 
-	glbContext = myContext;
+}
+
+void QccView::initializeGL()
+{
+	/* wrap the context Qt made current for this widget */
+	Handle(OpenGl_Context) aGlCtx = new OpenGl_Context();
+	if (!aGlCtx->Init())
+	{
+		qDebug() << "OpenGl_Context::Init() failed";
+		return;
+	}
+
+	const qreal aRatio = devicePixelRatioF();
+	if (myWindow.IsNull())
+	{
+		myWindow = new Aspect_NeutralWindow();
+		myWindow->SetVirtual(Standard_True);
+	}
+	myWindow->SetNativeHandle(aGlCtx->Window());
+	myWindow->SetSize(static_cast<int>(width() * aRatio), static_cast<int>(height() * aRatio));
+	myView->SetWindow(myWindow, aGlCtx->RenderingContext());
+}
+
+void QccView::paintGL()
+{
+	if (myView->Window().IsNull())
+		return;
+
+	/* Qt renders the widget into its own framebuffer, occt has to draw there */
+	Handle(OpenGl_Context) aGlCtx = Handle(OpenGl_GraphicDriver)::DownCast(myDriver)->GetSharedContext();
+	Handle(OpenGl_FrameBuffer) aDefaultFbo = aGlCtx->DefaultFrameBuffer();
+	if (aDefaultFbo.IsNull())
+	{
+		aDefaultFbo = new OpenGl_FrameBuffer();
+		aGlCtx->SetDefaultFrameBuffer(aDefaultFbo);
+	}
+	if (!aDefaultFbo->InitWrapper(aGlCtx))
+	{
+		qDebug() << "can not wrap the widget framebuffer";
+		return;
+	}
+
+	FrameKind aKind = myScheduler->take();
+	FrameStats::Scope timer(myStats, aKind == FrameKind::Immediate ? StatKind::Immediate : StatKind::Frame);
+	Handle(FrameView)::DownCast(myView)->paint(aKind);
+}
+
+void QccView::resizeGL(int theWidth, int theHeight)
+{
+	if (myWindow.IsNull())
+		return;
+
+	const qreal aRatio = devicePixelRatioF();
+	myWindow->SetSize(static_cast<int>(theWidth * aRatio), static_cast<int>(theHeight * aRatio));
+	myView->MustBeResized();
+	emit viewChanged();
 }
 
 const Handle(AIS_InteractiveContext)& QccView::getContext() const
@@ -91,31 +205,344 @@ const Standard_Integer QccView::getSelectMode() const
 	return mySelectMode;
 }
 
-void QccView::selectionChanged()
+bool QccView::selectionChanged()
 {
 	mySelection = myContext->Selection();
+
+	std::vector<Handle(SelectMgr_EntityOwner)> owners;
+	for (mySelection->Init(); mySelection->More(); mySelection->Next())
+		owners.push_back(mySelection->Value());
+	if (owners == mySelectedOwners)
+		return false;
+
+	mySelectedOwners.swap(owners);
+	return true;
 }
 
-QPaintEngine* QccView::paintEngine() const
+void QccView::setSelectionPreview(bool isOn)
 {
-	return 0;
+	myIsPreviewOn = isOn;
 }
 
-void QccView::paintEvent(QPaintEvent* /*theEvent*/)
+FrameStats& QccView::frameStats(void)
 {
-	myView->Redraw();
+	return myStats;
+}
+
+ShapeInstancer& QccView::instancer(void)
+{
+	return myInstancer;
+}
+
+void QccView::beginDisplay(void)
+{
+	myDisplayDepth++;
+}
+
+void QccView::commitDisplay(void)
+{
+	if (myDisplayDepth == 0 || --myDisplayDepth > 0)
+		return;
+
+	/* swap first, a display call may open a transaction of its own */
+	std::vector<DisplayCall> aCalls;
+	aCalls.swap(myDisplayCalls);
+	if (aCalls.empty())
+		return;
+
+	FrameStats::Scope timer(myStats, StatKind::Display);
+	for (const DisplayCall& aCall : aCalls)
+	{
+		/* workers are filling its selections, the call waits for selectionPrepared() */
+		if (myPreparingSet.count(aCall.obj.get()))
+		{
+			myHeldCalls.push_back(aCall);
+			continue;
+		}
+		switch (aCall.type)
+		{
+		case DisplayCall::Type::Display:
+		{
+			int aDispMode = aCall.dispMode >= 0 ? aCall.dispMode
+				: (aCall.obj->HasDisplayMode() ? aCall.obj->DisplayMode() : myContext->DisplayMode());
+			if (aCall.selMode == SelectionDeferred)
+			{
+				myContext->Display(aCall.obj, aDispMode, -1, Standard_False);
+				myDeferredObjects.push_back(aCall.obj);
+			}
+			else if (aCall.dispMode < 0 && aCall.selMode == 0)
+				myContext->Display(aCall.obj, Standard_False);
+			else
+				myContext->Display(aCall.obj, aDispMode, aCall.selMode, Standard_False);
+			myTriangles[aCall.obj.get()] = triangleCount(aCall.obj);
+			break;
+		}
+		case DisplayCall::Type::Erase:
+			myContext->Erase(aCall.obj, Standard_False);
+			break;
+		case DisplayCall::Type::Remove:
+			myContext->Remove(aCall.obj, Standard_False);
+			myTriangles.erase(aCall.obj.get());
+			break;
+		case DisplayCall::Type::Redisplay:
+			myContext->Redisplay(aCall.obj, Standard_False);
+			myTriangles[aCall.obj.get()] = triangleCount(aCall.obj);
+			break;
+		case DisplayCall::Type::Color:
+			myContext->SetColor(aCall.obj, aCall.color, Standard_False);
+			break;
+		}
+	}
+	myContext->UpdateCurrentViewer();
+
+	std::vector<Handle(AIS_InteractiveObject)> aDeferred;
+	aDeferred.swap(myDeferredObjects);
+	prepareSelection(aDeferred);
+}
+
+void QccView::prepareSelection(const std::vector<Handle(AIS_InteractiveObject)>& objs)
+{
+	/* an object is queued once, two workers must never fill the same selection */
+	std::set<const AIS_InteractiveObject*> aQueued;
+	for (const Handle(AIS_InteractiveObject)& anObj : myPreparingObjects)
+		aQueued.insert(anObj.get());
+	for (const Handle(AIS_InteractiveObject)& anObj : myWaitingObjects)
+		aQueued.insert(anObj.get());
+	for (const Handle(AIS_InteractiveObject)& anObj : objs)
+	{
+		if (aQueued.insert(anObj.get()).second)
+			myWaitingObjects.push_back(anObj);
+	}
+	if (mySelectionWatcher.isRunning() || myWaitingObjects.empty())
+		return;
+
+	/* an instance fills its entities from its reference, references go first */
+	std::vector<Handle(AIS_InteractiveObject)> aReferences;
+	std::set<const AIS_InteractiveObject*> aSeen;
+	for (const Handle(AIS_InteractiveObject)& anObj : myWaitingObjects)
+	{
+		Handle(AIS_ConnectedInteractive) anInstance = Handle(AIS_ConnectedInteractive)::DownCast(anObj);
+		if (!anInstance.IsNull() && anInstance->HasConnection() && aSeen.insert(anInstance->ConnectedTo().get()).second)
+			aReferences.push_back(anInstance->ConnectedTo());
+	}
+
+	myPreparingObjects.swap(myWaitingObjects);
+	myWaitingObjects.clear();
+	myPreparingSet.clear();
+	for (const Handle(AIS_InteractiveObject)& anObj : myPreparingObjects)
+		myPreparingSet.insert(anObj.get());
+	myPreparingSet.insert(aSeen.begin(), aSeen.end());
+	myPreparingMode = activeMode();
+	int aMode = myPreparingMode;
+	std::vector<Handle(AIS_InteractiveObject)> anObjects = myPreparingObjects;
+	mySelectionWatcher.setFuture(TaskScheduler::instance().run([aReferences, anObjects, aMode]() {
+		Tracer::Span aSpan("prepare selection", "selection");
+		aSpan.arg("objects", static_cast<double>(anObjects.size()));
+		auto compute = [aMode](const Handle(AIS_InteractiveObject)& anObj) {
+			if (!anObj->HasSelection(aMode))
+				anObj->RecomputePrimitives(aMode);
+		};
+		TaskScheduler& aScheduler = TaskScheduler::instance();
+		aScheduler.parallelFor(0, static_cast<int>(aReferences.size()),
+			[&](int i) { compute(aReferences[i]); }, TaskPriority::Interactive);
+		aScheduler.parallelFor(0, static_cast<int>(anObjects.size()),
+			[&](int i) { compute(anObjects[i]); }, TaskPriority::Interactive);
+	}, TaskPriority::Interactive));
+}
+
+void QccView::selectionPrepared(void)
+{
+	/* the mode may have changed meanwhile, those objects wait for the next round */
+	std::vector<Handle(AIS_InteractiveObject)> aPrepared;
+	aPrepared.swap(myPreparingObjects);
+	myPreparingSet.clear();
+	int aMode = activeMode();
+	for (const Handle(AIS_InteractiveObject)& anObj : aPrepared)
+	{
+		if (!myContext->IsDisplayed(anObj))
+			continue;
+		if (anObj->HasSelection(aMode))
+			myContext->Activate(anObj, aMode, Standard_False);
+		else
+			myWaitingObjects.push_back(anObj);
+	}
+
+	/* the removes and redisplays held back meanwhile, in their order */
+	if (!myHeldCalls.empty())
+	{
+		beginDisplay();
+		myDisplayCalls.insert(myDisplayCalls.end(), myHeldCalls.begin(), myHeldCalls.end());
+		myHeldCalls.clear();
+		commitDisplay();
+	}
+	prepareSelection(std::vector<Handle(AIS_InteractiveObject)>());
+}
+
+int QccView::activeMode(void) const
+{
+	return mySelectMode < 0 ? 0 : mySelectMode;
+}
+
+void QccView::setSelectMode(int mode)
+{
+	mySelectMode = mode;
+
+	/*
+	* entities computed once are kept by the objects, only missing ones go to
+	* workers; objects being prepared are not active and are not touched, the
+	* selection list they are filling is not read here
+	*/
+	AIS_ListOfInteractive aList;
+	myContext->DisplayedObjects(aList);
+	std::vector<Handle(AIS_InteractiveObject)> aMissing;
+	for (const Handle(AIS_InteractiveObject)& anObj : aList)
+	{
+		if (myPreparingSet.count(anObj.get()))
+			continue;
+		myContext->Deactivate(anObj);
+		if (anObj->HasSelection(mode))
+			myContext->Activate(anObj, mode, Standard_False);
+		else
+			aMissing.push_back(anObj);
+	}
+	prepareSelection(aMissing);
+}
+
+void QccView::eraseAll(void)
+{
+	/* EraseAll deactivates every object, none may be filled by a worker meanwhile */
+	mySelectionWatcher.waitForFinished();
+	myContext->EraseAll(Standard_True);
+}
+
+void QccView::display(const Handle(AIS_InteractiveObject)& obj, int dispMode, int selMode)
+{
+	DisplayBatch batch(this);
+	myDisplayCalls.push_back({ DisplayCall::Type::Display, obj, dispMode, selMode, Quantity_Color() });
+}
+
+void QccView::erase(const Handle(AIS_InteractiveObject)& obj)
+{
+	DisplayBatch batch(this);
+	myDisplayCalls.push_back({ DisplayCall::Type::Erase, obj, -1, 0, Quantity_Color() });
+}
+
+void QccView::remove(const Handle(AIS_InteractiveObject)& obj)
+{
+	DisplayBatch batch(this);
+	myDisplayCalls.push_back({ DisplayCall::Type::Remove, obj, -1, 0, Quantity_Color() });
+}
+
+void QccView::redisplay(const Handle(AIS_InteractiveObject)& obj)
+{
+	DisplayBatch batch(this);
+	myDisplayCalls.push_back({ DisplayCall::Type::Redisplay, obj, -1, 0, Quantity_Color() });
+}
+
+void QccView::setColor(const Handle(AIS_InteractiveObject)& obj, const Quantity_Color& color)
+{
+	/* an object not shown yet only takes the attribute, no recompute */
+	if (!myContext->IsDisplayed(obj))
+	{
+		obj->SetColor(color);
+		return;
+	}
+	DisplayBatch batch(this);
+	myDisplayCalls.push_back({ DisplayCall::Type::Color, obj, -1, 0, color });
+}
+
+bool QccView::exportStats(const QString& fileName) const
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+	file.write(QJsonDocument(myStats.toJson()).toJson());
+	return true;
+}
+
+void QccView::showStats(bool isOn)
+{
+	/* occt counts fps and gpu side elements, our label the cpu timings */
+	myView->ChangeRenderingParams().ToShowStats = isOn;
+	myView->ChangeRenderingParams().CollectedStats = Graphic3d_RenderingParams::PerfCounters_Basic;
+	if (myStatsLabel.IsNull())
+	{
+		myStatsLabel = new AIS_TextLabel();
+		myStatsLabel->SetColor(Quantity_NOC_YELLOW);
+		myStatsLabel->SetZLayer(Graphic3d_ZLayerId_TopOSD);
+		myStatsLabel->SetTransformPersistence(
+			new Graphic3d_TransformPers(Graphic3d_TMF_2d, Aspect_TOTP_RIGHT_UPPER, Graphic3d_Vec2i(260, 20)));
+	}
+
+	if (isOn)
+	{
+		myStats.reset();
+		statsTick();
+		myContext->Display(myStatsLabel, 0, -1, Standard_True);  //not selectable
+		myStatsTimer.start();
+	}
+	else
+	{
+		myStatsTimer.stop();
+		myContext->Remove(myStatsLabel, Standard_True);
+	}
 }
 
-void QccView::resizeEvent(QResizeEvent* /*theEvent*/)
+void QccView::statsTick(void)
 {
-	if (!myView.IsNull())
-		myView->MustBeResized();
+	/* scene size from the counts taken at display, instances count as drawn */
+	AIS_ListOfInteractive aList;
+	myContext->DisplayedObjects(aList);
+	int nbTriangles = 0;
+	for (const Handle(AIS_InteractiveObject)& anObj : aList)
+	{
+		auto it = myTriangles.find(anObj.get());
+		if (it != myTriangles.end())
+			nbTriangles += it->second;
+	}
+	myStats.setScene(aList.Extent(), nbTriangles);
+
+	/* TopOSD is an immediate layer, the new text needs no full frame */
+	myStatsLabel->SetText(TCollection_ExtendedString(myStats.summary().toUtf8().constData(), Standard_True));
+	if (myContext->IsDisplayed(myStatsLabel))
+	{
+		myContext->Redisplay(myStatsLabel, Standard_False);
+		myView->RedrawImmediate();
+	}
+}
+
+bool QccView::isBoxInView(const Bnd_Box& box, int minPixels) const
+{
+	if (box.IsVoid())
+		return false;
+
+	/* screen rectangle of the 8 projected corners */
+	gp_Pnt pMin = box.CornerMin();
+	gp_Pnt pMax = box.CornerMax();
+	Standard_Integer xMin = INT_MAX, yMin = INT_MAX, xMax = INT_MIN, yMax = INT_MIN;
+	for (int i = 0; i < 8; i++)
+	{
+		Standard_Integer xp = 0, yp = 0;
+		myView->Convert((i & 1) ? pMax.X() : pMin.X(), (i & 2) ? pMax.Y() : pMin.Y(),
+			(i & 4) ? pMax.Z() : pMin.Z(), xp, yp);
+		xMin = std::min(xMin, xp);
+		yMin = std::min(yMin, yp);
+		xMax = std::max(xMax, xp);
+		yMax = std::max(yMax, yp);
+	}
+
+	if (xMax < 0 || yMax < 0 || xMin > width() || yMin > height())
+		return false;
+	return xMax - xMin >= minPixels || yMax - yMin >= minPixels;
 }
 
-void QccView::show(const TopoDS_Shape& shp)
+std::vector<Handle(AIS_InteractiveObject)> QccView::show(const TopoDS_Shape& shp)
 {
-	Handle(AIS_Shape) aisShp = new AIS_Shape(shp);
-	this->myContext->Display(aisShp, Standard_True);
+	/* repeated parts of an assembly share one presentation */
+	FrameStats::Scope timer(myStats, StatKind::Display);
+	std::vector<Handle(AIS_InteractiveObject)> objs = myInstancer.display(myContext, shp, true);
+	prepareSelection(objs);
+	return objs;
 }
 
 void QccView::zoom(void)
@@ -136,6 +563,7 @@ void QccView::rotate(void)
 void QccView::reset(void)
 {
 	myView->Reset();
+	emit viewChanged();
 }
 
 void QccView::fitAll(void)
@@ -143,6 +571,7 @@ void QccView::fitAll(void)
 	myView->FitAll();
 	myView->ZFitAll();
 	//myView->Redraw();
+	emit viewChanged();
 }
 
 void QccView::redraw(void)
@@ -246,6 +675,7 @@ void QccView::onLButtonDown(const int theFlags, const QPoint thePoint)
 	myYmin = thePoint.y();
 	myXmax = thePoint.x();
 	myYmax = thePoint.y();
+	myIsPreviewed = false;
 
 	if (theFlags & Qt::ControlModifier)
 	{
@@ -310,15 +740,26 @@ void QccView::onMButtonDown(const int /*theFlags*/, const QPoint thePoint)
 
 void QccView::onLButtonUp(const int theFlags, const QPoint thePoint)
 {
-	/* Hide the QRubberBand */
-	if (myRectBand)
+	/* select the rubber band rectangle once, on release */
+	myPreviewTimer.stop();
+	if (myRectBand && myRectBand->isVisible())
 	{
 		myRectBand->hide();
-		emit selectSig();
+		/* a previewed band has replaced the selection already, Ctrl would toggle it off again */
+		if ((theFlags & Qt::ControlModifier) && !myIsPreviewed)
+			multiDragEvent(thePoint.x(), thePoint.y());
+		else
+			dragEvent(thePoint.x(), thePoint.y());
 	}
 
 	/* reset myManipulator */
 	myManipulator->StopTransform(Standard_True);
+	if (myCurrentMode == CurrentAction3d::CurAction3d_Manipulating && myManipulator->IsAttached())
+		emit moveSig(myManipulator->Object());
+
+	if (myCurrentMode == CurrentAction3d::CurAction3d_DynamicPanning
+		|| myCurrentMode == CurrentAction3d::CurAction3d_DynamicZooming)
+		emit viewChanged();
 
 	/* click the shape? */
 	if (thePoint.x() == myXmin && thePoint.y() == myYmin)
@@ -344,6 +785,7 @@ void QccView::onMButtonUp(const int theFlags, const QPoint thePoint)
 	{
 		panByMiddleButton(thePoint);
 	}
+	emit viewChanged();
 }
 
 void QccView::onRButtonUp(const int theFlags, const QPoint thePoint)
@@ -377,7 +819,10 @@ void QccView::onMouseMove(const int theFlags, const QPoint thePoint)
 		else
 		{
 			drawRubberBand(myXmin, myYmin, thePoint.x(), thePoint.y());
-			dragEvent(thePoint.x(), thePoint.y());
+			myDragPos = thePoint;
+			/* no preview for a Ctrl band, it adds to the selection on release */
+			if (myIsPreviewOn && !(theFlags & Qt::ControlModifier) && !myPreviewTimer.isActive())
+				myPreviewTimer.start();
 		}
 	}
 
@@ -388,6 +833,13 @@ void QccView::onMouseMove(const int theFlags, const QPoint thePoint)
 			myView->Rotation(thePoint.x(), thePoint.y());
 	}
 
+	/* no hover while a button drives the camera, the manipulator or the rubber band */
+	if (theFlags & (Qt::LeftButton | Qt::MidButton | Qt::RightButton))
+	{
+		myHoverTimer.stop();
+		return;
+	}
+
 	/* Ctrl for multi selection */
 	if (theFlags & Qt::ControlModifier)
 	{
@@ -417,6 +869,7 @@ void QccView::onMouseWheel(const int /*theFlags*/, const int theDelta, const QPo
 	}
 
 	myView->Zoom(thePoint.x(), thePoint.y(), aX, aY);
+	emit viewChanged();
 }
 
 void QccView::drawRubberBand(const int minX, const int minY, const int maxX, const int maxY)
@@ -446,26 +899,62 @@ void QccView::drawRubberBand(const int minX, const int minY, const int maxX, con
 
 void QccView::multiDragEvent(const int x, const int y)
 {
-	myContext->ShiftSelect(myXmin, myYmin, x, y, myView, Standard_True);
+	{
+		FrameStats::Scope timer(myStats, StatKind::Pick);
+		myContext->ShiftSelect(myXmin, myYmin, x, y, myView, Standard_True);
+	}
 
-	selectionChanged();
+	if (selectionChanged())
+		emit selectSig();
 }
 
 void QccView::dragEvent(const int x, const int y)
 {
-	myContext->Select(myXmin, myYmin, x, y, myView, Standard_True);
+	{
+		FrameStats::Scope timer(myStats, StatKind::Pick);
+		myContext->Select(myXmin, myYmin, x, y, myView, Standard_True);
+	}
 	
-	selectionChanged();
+	if (selectionChanged())
+		emit selectSig();
+}
+
+void QccView::previewSelection(void)
+{
+	/* the preview only highlights, Qcc is told once the band is released */
+	if (!myRectBand || !myRectBand->isVisible())
+		return;
+	{
+		FrameStats::Scope timer(myStats, StatKind::Pick);
+		myContext->Select(myXmin, myYmin, myDragPos.x(), myDragPos.y(), myView, Standard_False);
+	}
+	myIsPreviewed = true;
+	myView->Redraw();
 }
 
 void QccView::multiMoveEvent(const int x, const int y)
 {
-	myContext->MoveTo(x, y, myView, Standard_True);
+	moveEvent(x, y);
 }
 
 void QccView::moveEvent(const int x, const int y)
 {
-	myContext->MoveTo(x, y, myView, Standard_True);
+	/* later moves in the same frame only replace the position */
+	myHoverPos = QPoint(x, y);
+	if (!myHoverTimer.isActive())
+		myHoverTimer.start();
+}
+
+void QccView::hover(void)
+{
+	/* pick without redraw, then schedule an immediate frame if the highlight changed */
+	Handle(SelectMgr_EntityOwner) aLastOwner = myContext->DetectedOwner();
+	{
+		FrameStats::Scope timer(myStats, StatKind::Pick);
+		myContext->MoveTo(myHoverPos.x(), myHoverPos.y(), myView, Standard_False);
+	}
+	if (myContext->DetectedOwner() != aLastOwner)
+		myView->RedrawImmediate();
 }
 
 void QccView::multiInputEvent(const int x, const int y)
@@ -473,9 +962,13 @@ void QccView::multiInputEvent(const int x, const int y)
 	Q_UNUSED(x);
 	Q_UNUSED(y);
 
-	myContext->ShiftSelect(Standard_True);
+	{
+		FrameStats::Scope timer(myStats, StatKind::Pick);
+		myContext->ShiftSelect(Standard_True);
+	}
 
-	selectionChanged();
+	if (selectionChanged())
+		emit selectSig();
 }
 
 void QccView::inputEvent(const int x, const int y)
@@ -483,9 +976,13 @@ void QccView::inputEvent(const int x, const int y)
 	Q_UNUSED(x);
 	Q_UNUSED(y);
 
-	myContext->Select(Standard_True);
+	{
+		FrameStats::Scope timer(myStats, StatKind::Pick);
+		myContext->Select(Standard_True);
+	}
 
-	selectionChanged();
+	if (selectionChanged())
+		emit selectSig();
 }
 
 void QccView::addItemInPopup(QMenu* /*theMenu*/)
@@ -511,49 +1008,35 @@ void QccView::panByMiddleButton(const QPoint& thePoint)
 
 void QccView::selectShape()
 {
-	mySelectMode = AIS_Shape::SelectionMode(TopAbs_SHAPE);
-	myContext->Deactivate();
-	myContext->Activate(mySelectMode);
+	setSelectMode(AIS_Shape::SelectionMode(TopAbs_SHAPE));
 }
 
 void QccView::selectSolid()
 {
-	mySelectMode = AIS_Shape::SelectionMode(TopAbs_SOLID);
-	myContext->Deactivate();
-	myContext->Activate(mySelectMode);
+	setSelectMode(AIS_Shape::SelectionMode(TopAbs_SOLID));
 }
 
 void QccView::selectShell()
 {
-	mySelectMode = AIS_Shape::SelectionMode(TopAbs_SHELL);
-	myContext->Deactivate();
-	myContext->Activate(mySelectMode);
+	setSelectMode(AIS_Shape::SelectionMode(TopAbs_SHELL));
 }
 
 void QccView::selectFace()
 {	
-	mySelectMode = AIS_Shape::SelectionMode(TopAbs_FACE);
-	myContext->Deactivate();
-	myContext->Activate(mySelectMode);
+	setSelectMode(AIS_Shape::SelectionMode(TopAbs_FACE));
 }
 
 void QccView::selectWire()
 {
-	mySelectMode = AIS_Shape::SelectionMode(TopAbs_WIRE);
-	myContext->Deactivate();
-	myContext->Activate(mySelectMode);
+	setSelectMode(AIS_Shape::SelectionMode(TopAbs_WIRE));
 }
 
 void QccView::selectEdge()
 {
-	mySelectMode = AIS_Shape::SelectionMode(TopAbs_EDGE);
-	myContext->Deactivate();
-	myContext->Activate(mySelectMode);
+	setSelectMode(AIS_Shape::SelectionMode(TopAbs_EDGE));
 }
 
 void QccView::selectVertex()
 {
-	mySelectMode = AIS_Shape::SelectionMode(TopAbs_VERTEX);
-	myContext->Deactivate();
-	myContext->Activate(mySelectMode);
+	setSelectMode(AIS_Shape::SelectionMode(TopAbs_VERTEX));
 }
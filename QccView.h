@@ -1,28 +1,32 @@
 #pragma once
 
 #include <QWidget>
-#include <QGLWidget>
+#include <QOpenGLWidget>
 #include <QRubberband>
+#include <QTimer>
+#include <QFutureWatcher>
 #include <chrono>
-#ifdef _WIN32
-#include <WNT_Window.hxx>
-#else
-#undef None
-#include <Xw_Window.hxx>
-#endif
-
+#include <vector>
+#include <map>
+#include <set>
+#include <Aspect_NeutralWindow.hxx>
 #include <V3d_View.hxx>
 #include <V3d_Viewer.hxx>
 #include <AIS_Shape.hxx>
 #include <AIS_ViewController.hxx>
 #include <AIS_InteractiveContext.hxx>
 #include <AIS_Manipulator.hxx>
+#include <AIS_TextLabel.hxx>
+#include <Bnd_Box.hxx>
+#include "FrameStats.h"
+#include "FrameScheduler.h"
+#include "ShapeInstancer.h"
 
 class QMenu;
 class QRubberBand;
 class RotCircle;
 
-class QccView : public QGLWidget
+class QccView : public QOpenGLWidget
 {
     Q_OBJECT
 
@@ -39,12 +43,47 @@ public:
         CurAction3d_Manipulating,
     };
 
+    /* display() selection mode: no selection until it is computed on workers */
+    static const int SelectionDeferred = -2;
+
 public:
     QccView(QWidget* parent);
+    ~QccView();
     const Handle(AIS_InteractiveContext)& getContext() const;
     const Handle(AIS_Selection)& getSelection() const;
     const Standard_Integer getSelectMode() const;
-    void selectionChanged(void);
+    /* refresh mySelection, true if the selected owners differ from the last call */
+    bool selectionChanged(void);
+    /* the box projects inside the viewport and spans at least minPixels */
+    bool isBoxInView(const Bnd_Box& box, int minPixels) const;
+    /* redraw, pick and display timings */
+    FrameStats& frameStats(void);
+    bool exportStats(const QString& fileName) const;
+    /* shared presentations of repeated shapes */
+    ShapeInstancer& instancer(void);
+
+    /*
+    * display transaction: between beginDisplay() and commitDisplay() the
+    * calls below are queued, the outermost commit applies them and updates
+    * the viewer once. Outside a transaction each call updates at once.
+    */
+    void beginDisplay(void);
+    void commitDisplay(void);
+    /* dispMode -1 is the object's own, selMode -1 is not selectable */
+    void display(const Handle(AIS_InteractiveObject)& obj, int dispMode = -1, int selMode = 0);
+    void erase(const Handle(AIS_InteractiveObject)& obj);
+    void remove(const Handle(AIS_InteractiveObject)& obj);
+    void redisplay(const Handle(AIS_InteractiveObject)& obj);
+    void setColor(const Handle(AIS_InteractiveObject)& obj, const Quantity_Color& color);
+    /* erase everything at once, after a running selection job */
+    void eraseAll(void);
+
+    /*
+    * compute the sensitive entities of the current select mode on workers,
+    * the objects are activated once theirs are ready; display calls for an
+    * object in the running job are held back until it is done
+    */
+    void prepareSelection(const std::vector<Handle(AIS_InteractiveObject)>& objs);
 
 signals:
     void obbSig(void);
@@ -52,10 +91,15 @@ signals:
     void meshSig(bool);
     void deleteSig(void);
     void selectSig(void);
+    /* the manipulator has moved the object */
+    void moveSig(const Handle(AIS_InteractiveObject)&);
+    /* camera moved: zoom, pan, rotation, fit or resize finished */
+    void viewChanged(void);
 
 public slots:
     /* operations for the view */
-    void show(const TopoDS_Shape&);
+    /* the presentations made for the shape */
+    std::vector<Handle(AIS_InteractiveObject)> show(const TopoDS_Shape&);
     void zoom(void);
     void pan(void);
     void rotate(void);
@@ -75,11 +119,25 @@ public slots:
     /* ais_manipulator */
     void initManipulator(void);
 
+    /* select live while dragging the rubber band, at most every 100 ms */
+    void setSelectionPreview(bool);
+
+    /* frame stats overlay, refreshed every second */
+    void showStats(bool);
+
+private slots:
+    /* deferred MoveTo for the last mouse position */
+    void hover(void);
+    /* rate limited Select of the current rubber band */
+    void previewSelection(void);
+    void statsTick(void);
+    void selectionPrepared(void);
+
 protected:
-    /* paint events */
-    virtual QPaintEngine* paintEngine() const;
-    virtual void paintEvent(QPaintEvent* theEvent);
-    virtual void resizeEvent(QResizeEvent* theEvent);
+    /* the view renders into the widget's framebuffer, only from paintGL */
+    virtual void initializeGL() override;
+    virtual void paintGL() override;
+    virtual void resizeGL(int theWidth, int theHeight) override;
 
     /* Mouse events */
     virtual void mousePressEvent(QMouseEvent* theEvent);
@@ -107,6 +165,9 @@ protected:
 protected:
     void initContext();
     void popup(const int x, const int y);
+    /* activate a select mode, reusing the entities objects already have */
+    void setSelectMode(int mode);
+    int activeMode(void) const;
 
     void multiDragEvent(const int x, const int y);
     void dragEvent(const int x, const int y);
@@ -124,7 +185,9 @@ private:
     Handle(AIS_InteractiveContext) myContext;
     Handle(AIS_Manipulator) myManipulator;
     Handle(V3d_Viewer) myViewer;
-    Handle(V3d_View) myView;
+    Handle(V3d_View) myView;  //a FrameView
+    Handle(Aspect_NeutralWindow) myWindow;
+    FrameScheduler* myScheduler;
     Handle(Graphic3d_GraphicDriver) myDriver;
     Handle(AIS_Selection) mySelection;
 
@@ -141,5 +204,51 @@ private:
     Standard_Boolean myDegenerateModeIsOn;
     /* rubber rectangle for the mouse selection */
     QRubberBand* myRectBand;
+    /* hover detection, coalesced to one MoveTo per frame */
+    QTimer myHoverTimer;
+    QPoint myHoverPos;
+    /* rubber band selection preview */
+    bool myIsPreviewOn;
+    bool myIsPreviewed;     //the preview has selected during this drag
+    QTimer myPreviewTimer;
+    QPoint myDragPos;
+    /* owners of the last selection, to tell a real change */
+    std::vector<Handle(SelectMgr_EntityOwner)> mySelectedOwners;
+    /* frame stats */
+    FrameStats myStats;
+    QTimer myStatsTimer;
+    Handle(AIS_TextLabel) myStatsLabel;
+    std::map<const AIS_InteractiveObject*, int> myTriangles;  //counted when displayed
+    ShapeInstancer myInstancer;
+    /* queued display calls of the open transaction */
+    struct DisplayCall
+    {
+        enum class Type { Display, Erase, Remove, Redisplay, Color } type;
+        Handle(AIS_InteractiveObject) obj;
+        int dispMode;
+        int selMode;
+        Quantity_Color color;
+    };
+    std::vector<DisplayCall> myDisplayCalls;
+    int myDisplayDepth;
+    /* selections computed on workers, see prepareSelection() */
+    std::vector<Handle(AIS_InteractiveObject)> myDeferredObjects;
+    std::vector<Handle(AIS_InteractiveObject)> myPreparingObjects;
+    std::vector<Handle(AIS_InteractiveObject)> myWaitingObjects;
+    std::set<const AIS_InteractiveObject*> myPreparingSet;  //objects and references of the running job
+    std::vector<DisplayCall> myHeldCalls;
+    int myPreparingMode;
+    QFutureWatcher<void> mySelectionWatcher;
+};
+
+/* opens a display transaction on a view and commits it at scope exit */
+class DisplayBatch
+{
+public:
+    explicit DisplayBatch(QccView* view) : view(view) { view->beginDisplay(); }
+    ~DisplayBatch() { view->commitDisplay(); }
+
+private:
+    QccView* view;
 };
 
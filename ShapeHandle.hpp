@@ -2,13 +2,13 @@
 
 #include "Qcc.h"
 #include "QccView.h"
+#include "FaceTable.h"
+#include "ModelGenerator.h"
 #include <QDebug>
 #include <algorithm>
 #include <string>
 #include <vector>
 #include <cmath>
-#include <cstdlib>
-#include <ctime>
 
 #include <NCollection_Mat4.hxx>
 #include <IMeshTools_Parameters.hxx>
@@ -57,22 +57,20 @@
 #include <gp_Pnt.hxx>
 #include <gp_Trsf.hxx>
 
-#define random(x) rand()%(x*2)-x+rand()/double(RAND_MAX)
-
 using std::vector;
 
 namespace Hand
 {
     bool isSameTrsf(gp_Trsf t1, gp_Trsf t2, double precision = 0.0001);
-    void displaySelected(Handle(AIS_Shape) aisObj);
-    double getDihedralAngle(TopoDS_Edge& edge, TopoDS_ListOfShape& findFace, TopoDS_Shape& myShape);
+    void displaySelected(const Handle(AIS_InteractiveContext)& context, Handle(AIS_Shape) aisObj);
+    double getDihedralAngle(const Handle(AIS_InteractiveContext)& context, TopoDS_Edge& edge, TopoDS_ListOfShape& findFace, TopoDS_Shape& myShape);
     double getEdgeLength(TopoDS_Shape& edge);
     gp_Vec getEdgeNormal(TopoDS_Edge aedge, bool fromStart);
     gp_Vec getPlaneNormal(TopoDS_Face& face);
     void getSurfType(TopoDS_Face& face);
     void transformBy(Handle(AIS_InteractiveObject) obj, gp_Trsf trsf);
 
-    vector<gp_Pnt> geneRandTri(void);
+    vector<gp_Pnt> geneRandTri(unsigned int seed = 1);
     double getFaceArea(const TopoDS_Shape& face);
     double getBndArea(const Bnd_OBB& bndObb, double enlarge = 0.0001);
 
@@ -83,7 +81,7 @@ namespace Hand
     Bnd_Box getFullAABB(Handle(AIS_Shape) shp);
 
     vector<TopoDS_Face> geneFaceTri(TopoDS_Face& topoFace);
-    vector<gp_Pnt> transformTriPnts(std::vector<gp_Pnt>& triPnt, gp_Trsf& trsf);
+    void transformTriPnts(const gp_Pnt (&triPnt)[3], const gp_Trsf& trsf, gp_Pnt (&tTri)[3]);
 
     bool isAABBCollideTri(Bnd_OBB& bndObb, TopoDS_Face& triFace);
     bool isOBBCollideTri(Bnd_OBB& bndObb, TopoDS_Face& triFace);
@@ -109,7 +107,7 @@ static bool Hand::isSameTrsf(gp_Trsf t1, gp_Trsf t2, double precision)
     return true;
 }
 
-static void Hand::displaySelected(Handle(AIS_Shape) aisObj)
+static void Hand::displaySelected(const Handle(AIS_InteractiveContext)& context, Handle(AIS_Shape) aisObj)
 {
     if (aisObj->Children().Size() > 0)
     {
@@ -121,7 +119,7 @@ static void Hand::displaySelected(Handle(AIS_Shape) aisObj)
             if (t_object->IsKind(STANDARD_TYPE(AIS_Shape)))
             {
                 Handle(AIS_Shape) t_child_model = Handle(AIS_Shape)::DownCast(t_object);
-                displaySelected(t_child_model);
+                displaySelected(context, t_child_model);
             }
         }
     }
@@ -129,11 +127,11 @@ static void Hand::displaySelected(Handle(AIS_Shape) aisObj)
     {
         aisObj->SetColor(Quantity_NOC_FIREBRICK);
         aisObj->SetTransparency(0.7);
-        glbContext->Display(aisObj, Standard_True);
+        context->Display(aisObj, Standard_True);
     }
 }
 
-static double Hand::getDihedralAngle(TopoDS_Edge& edge, TopoDS_ListOfShape& findFace, TopoDS_Shape& myShape)
+static double Hand::getDihedralAngle(const Handle(AIS_InteractiveContext)& context, TopoDS_Edge& edge, TopoDS_ListOfShape& findFace, TopoDS_Shape& myShape)
 {
     Standard_Real first, last;
     Handle(Geom_Curve) curve = BRep_Tool::Curve(edge, first, last);
@@ -179,7 +177,7 @@ static double Hand::getDihedralAngle(TopoDS_Edge& edge, TopoDS_ListOfShape& find
     TopoDS_Shape wire2 = BRepAlgoAPI_Cut(wire1, myShape).Shape();
 
     Handle(AIS_Shape) aisWire = new AIS_Shape(wire2);
-    glbContext->Display(aisWire, Standard_True);
+    context->Display(aisWire, Standard_True);
 
     double len1 = Hand::getEdgeLength(wire1);
     double len2 = Hand::getEdgeLength(wire2);
@@ -245,42 +243,7 @@ static void Hand::getSurfType(TopoDS_Face& face)
     GeomAdaptor_Surface GAS(gfc);
     GeomAbs_SurfaceType faceType = GAS.GetType();
 
-    switch (faceType)
-    {
-    case 0:
-        qDebug() << "Face type is: GeomAbs_Plane";
-        break;
-    case 1:
-        qDebug() << "Face type is: GeomAbs_Cylinder";
-        break;
-    case 2:
-        qDebug() << "Face type is: GeomAbs_Cone";
-        break;
-    case 3:
-        qDebug() << "Face type is: GeomAbs_Sphere";
-        break;
-    case 4:
-        qDebug() << "Face type is: GeomAbs_Torus";
-        break;
-    case 5:
-        qDebug() << "Face type is: GeomAbs_BezierSurface";
-        break;
-    case 6:
-        qDebug() << "Face type is: GeomAbs_BSplineSurface";
-        break;
-    case 7:
-        qDebug() << "Face type is: GeomAbs_SurfaceOfRevolution";
-        break;
-    case 8:
-        qDebug() << "Face type is: GeomAbs_SurfaceOfExtrusion";
-        break;
-    case 9:
-        qDebug() << "Face type is: GeomAbs_OffsetSurface";
-        break;
-    case 10:
-        qDebug() << "Face type is: GeomAbs_OtherSurface";
-        break;
-    }
+    qDebug() << "Face type is:" << FaceTable::typeName(faceType);
 }
 
 static void Hand::transformBy(Handle(AIS_InteractiveObject) obj, gp_Trsf trsf)
@@ -299,26 +262,14 @@ static void Hand::transformBy(Handle(AIS_InteractiveObject) obj, gp_Trsf trsf)
     obj->SetLocalTransformation(trans);
 }
 
-static vector<gp_Pnt> Hand::geneRandTri()
+static vector<gp_Pnt> Hand::geneRandTri(unsigned int seed)
 {
-    /* create three point as triangle */
-    vector<gp_Pnt> ret;
-    srand((int)time(0));
-    double x = random(15);
-    double y = random(15);
-    double z = random(15);
-    gp_Pnt p(x, y, z);
-    ret.push_back(p);
-
-    gp_Trsf trsf1;
-    trsf1.SetTranslation(gp_Vec(random(2), random(2), random(2)));
-    ret.push_back(p.Transformed(trsf1));
-
-    gp_Trsf trsf2;
-    trsf2.SetTranslation(gp_Vec(random(2), random(2), random(2)));
-    ret.push_back(p.Transformed(trsf2));
-    
-    return ret;
+    /* create three point as triangle, the same one for the same seed */
+    GeneratorOptions options;
+    options.seed = seed;
+    options.extent = 30.0;
+    std::array<gp_Pnt, 3> tri = ModelGenerator(options).triangleSoup(1, 2.0).front();
+    return vector<gp_Pnt>(tri.begin(), tri.end());
 }
 
 static vector<TopoDS_Face> Hand::geneFaceTri(TopoDS_Face& topoFace)
@@ -349,35 +300,27 @@ static vector<TopoDS_Face> Hand::geneFaceTri(TopoDS_Face& topoFace)
     Handle(Poly_Triangulation) triMesh = BRep_Tool::Triangulation(meshFace, aLoc);
     if (triMesh)
     {
-        //for-loop mesh data and take triangle points
-        TColgp_Array1OfPnt aTriNodes(1, triMesh->NbNodes());
-        aTriNodes = triMesh->Nodes();
-        Poly_Array1OfTriangle aTriangles(1, triMesh->NbTriangles());
-        aTriangles = triMesh->Triangles();
+        //for-loop mesh data in place and take triangle points
+        const TColgp_Array1OfPnt& aTriNodes = triMesh->Nodes();
+        const Poly_Array1OfTriangle& aTriangles = triMesh->Triangles();
+        ret.reserve(triMesh->NbTriangles());
         for (int i = 1; i <= triMesh->NbTriangles(); i++)
         {
-            Poly_Triangle trian = aTriangles.Value(i);
             Standard_Integer index1, index2, index3;
-            trian.Get(index1, index2, index3);
-
-            gp_Pnt pnt1, pnt2, pnt3;
-            pnt1 = aTriNodes[index1];
-            pnt2 = aTriNodes[index2];
-            pnt3 = aTriNodes[index3];
+            aTriangles.Value(i).Get(index1, index2, index3);
 
-            vector<gp_Pnt> triPnt;
+            const gp_Pnt& pnt1 = aTriNodes[index1];
+            const gp_Pnt& pnt2 = aTriNodes[index2];
+            const gp_Pnt& pnt3 = aTriNodes[index3];
             if (pnt1.IsEqual(pnt2, 0.01) || pnt1.IsEqual(pnt3, 0.01) || pnt2.IsEqual(pnt3, 0.01))
                 continue;
-            triPnt.push_back(pnt1);
-            triPnt.push_back(pnt2);
-            triPnt.push_back(pnt3);
 
             //construct triangle face
             BRepBuilderAPI_MakePolygon mkPoly;
-            mkPoly.Add(triPnt[0]);
-            mkPoly.Add(triPnt[1]);
-            mkPoly.Add(triPnt[2]);
-            mkPoly.Add(triPnt[0]);
+            mkPoly.Add(pnt1);
+            mkPoly.Add(pnt2);
+            mkPoly.Add(pnt3);
+            mkPoly.Add(pnt1);
 
             BRepBuilderAPI_MakeFace mkFace(mkPoly.Wire());
             ret.push_back(mkFace.Face());
@@ -386,24 +329,30 @@ static vector<TopoDS_Face> Hand::geneFaceTri(TopoDS_Face& topoFace)
     return ret;
 }
 
-static bool Hand::isOBBCollideTri(Bnd_OBB& bndObb, TopoDS_Face& triFace)
+/* the 3 corners of a triangle face, in stack storage; false if it has less */
+static bool triFacePoints(const TopoDS_Face& triFace, gp_Pnt (&triPoints)[3])
 {
-    vector<gp_Pnt> triPoints;
-    int index = 0;
-    for (TopExp_Explorer exp(triFace, TopAbs_VERTEX); exp.More(); exp.Next())
+    int index = 0, nbPoints = 0;
+    for (TopExp_Explorer exp(triFace, TopAbs_VERTEX); exp.More() && nbPoints < 3; exp.Next())
     {
         if ((++index) % 2 == 0)
             continue;
-        TopoDS_Shape shape = exp.Current();
-        TopoDS_Vertex V = TopoDS::Vertex(shape);
-        gp_Pnt P = BRep_Tool::Pnt(V);
-        triPoints.push_back(P);
+        triPoints[nbPoints++] = BRep_Tool::Pnt(TopoDS::Vertex(exp.Current()));
     }
+    return nbPoints == 3;
+}
+
+static bool Hand::isOBBCollideTri(Bnd_OBB& bndObb, TopoDS_Face& triFace)
+{
+    /* fixed size data only, the test runs per triangle and allocates nothing */
+    gp_Pnt triPoints[3];
+    if (!triFacePoints(triFace, triPoints))
+        return false;
 
     gp_Vec f0(triPoints[0], triPoints[1]);
     gp_Vec f1(triPoints[1], triPoints[2]);
     gp_Vec f2(triPoints[2], triPoints[0]);
-    std::vector<gp_Vec> triVecs{ f0, f1, f2 };
+    const gp_Vec triVecs[3] = { f0, f1, f2 };
 
     gp_Vec bndXv = gp_Vec(bndObb.XDirection());
     gp_Vec bndYv = gp_Vec(bndObb.YDirection());
@@ -413,7 +362,7 @@ static bool Hand::isOBBCollideTri(Bnd_OBB& bndObb, TopoDS_Face& triFace)
     double bndY = bndObb.YHSize();
     double bndZ = bndObb.ZHSize();
     /* the bndVecs are all normalized */
-    std::vector<gp_Vec> boxVecs{ bndXv, bndYv, bndZv };
+    const gp_Vec boxVecs[3] = { bndXv, bndYv, bndZv };
    
     /* 1.check 9 crossed vectors results */
     for (int i = 0; i < 3; i++) //i is loop triVecs
@@ -486,40 +435,33 @@ static bool Hand::isOBBCollideTri(Bnd_OBB& bndObb, TopoDS_Face& triFace)
 static bool Hand::isAABBCollideTri(Bnd_OBB& bndObb, TopoDS_Face& triFace)
 {
     //transform Obb and Tri to AABB status
-    vector<gp_Pnt> triPoints;
-    int index = 0;
-    for (TopExp_Explorer exp(triFace, TopAbs_VERTEX); exp.More(); exp.Next())
-    {
-        if ((++index) % 2 == 0)
-            continue;
-        TopoDS_Shape shape = exp.Current();
-        TopoDS_Vertex V = TopoDS::Vertex(shape);
-        gp_Pnt P = BRep_Tool::Pnt(V);
-        triPoints.push_back(P);
-    }
+    gp_Pnt triPoints[3];
+    if (!triFacePoints(triFace, triPoints))
+        return false;
 
     gp_Trsf loc, locInvs;
     loc.SetTransformation(bndObb.Position(), gp::XOY());
     loc.Invert();
 
     Bnd_OBB tObb = Hand::transformOBB(bndObb, loc);
-    vector<gp_Pnt> tTri = Hand::transformTriPnts(triPoints, loc);
+    gp_Pnt tTri[3];
+    Hand::transformTriPnts(triPoints, loc, tTri);
 
     //OBBת
     gp_Vec e0(gp_Dir(1, 0, 0));
     gp_Vec e1(gp_Dir(0, 1, 0));
     gp_Vec e2(gp_Dir(0, 0, 1));
-    std::vector<gp_Vec> vecs{ e0,e1,e2 };
+    gp_Vec vecs[13] = { e0,e1,e2 };
 
     //ε3()
     gp_Vec f0(tTri[0], tTri[1]);
     gp_Vec f1(tTri[1], tTri[2]);
     gp_Vec f2(tTri[2], tTri[0]);
-    std::vector<gp_Vec> triVecs{ f0,f1,f2 };
+    const gp_Vec triVecs[3] = { f0,f1,f2 };
 
     //εһ
     gp_Vec e3 = f0.Crossed(f1).Normalized();
-    vecs.push_back(e3);
+    vecs[3] = e3;
 
     //xߵľŸ
     for (int i = 0; i < 3; i++)
@@ -530,7 +472,7 @@ static bool Hand::isAABBCollideTri(Bnd_OBB& bndObb, TopoDS_Face& triFace)
             gp_Vec e = vecs[i].Crossed(triVecs[j]);
             if (e.X() != 0 && e.Y() != 0 && e.Z() != 0)
                 e.Normalize();
-            vecs.push_back(e);
+            vecs[4 + i * 3 + j] = e;
         }
     }
 
@@ -649,15 +591,10 @@ static Bnd_OBB Hand::transformOBB(Bnd_OBB& bndObb, gp_Trsf& trsf)
     return bndret;
 }
 
-static vector<gp_Pnt> Hand::transformTriPnts(std::vector<gp_Pnt>& triPnt, gp_Trsf& trsf)
+static void Hand::transformTriPnts(const gp_Pnt (&triPnt)[3], const gp_Trsf& trsf, gp_Pnt (&tTri)[3])
 {
-    vector<gp_Pnt> tTri;
-    for (int i = 0; i < triPnt.size(); i++)
-    {
-        tTri.push_back(triPnt[i].Transformed(trsf));
-    }
-
-    return tTri;
+    for (int i = 0; i < 3; i++)
+        tTri[i] = triPnt[i].Transformed(trsf);
 }
 
 static TopoDS_Shape Hand::TriangleGetShape(std::vector<gp_Pnt>& triPoints)
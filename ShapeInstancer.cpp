@@ -0,0 +1,126 @@
+#include "ShapeInstancer.h"
+
+#include <AIS_ConnectedInteractive.hxx>
+#include <BRep_Builder.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Iterator.hxx>
+
+/* leaves of the compound tree, located with the composed compound locations */
+static void collectLeaves(const TopoDS_Shape& shp, vector<TopoDS_Shape>& leaves)
+{
+    if (shp.ShapeType() != TopAbs_COMPOUND)
+    {
+        leaves.push_back(shp);
+        return;
+    }
+    for (TopoDS_Iterator it(shp); it.More(); it.Next())
+        collectLeaves(it.Value(), leaves);
+}
+
+ShapeInstancer::ShapeInstancer()
+{
+
+}
+
+ShapeInstancer::~ShapeInstancer()
+{
+
+}
+
+ShapeInstancer::Key ShapeInstancer::keyOf(const TopoDS_Shape& shp)
+{
+    return Key(shp.TShape().get(), shp.Orientation());
+}
+
+Handle(AIS_Shape) ShapeInstancer::reference(const TopoDS_Shape& shp)
+{
+    Handle(AIS_Shape)& aReference = references[keyOf(shp)];
+    if (aReference.IsNull())
+        aReference = new AIS_Shape(shp.Located(TopLoc_Location()));
+    return aReference;
+}
+
+Handle(AIS_InteractiveObject) ShapeInstancer::instance(const TopoDS_Shape& shp)
+{
+    Handle(AIS_ConnectedInteractive) anInstance = new AIS_ConnectedInteractive();
+    anInstance->Connect(reference(shp));
+    anInstance->SetLocalTransformation(shp.Location().Transformation());
+    return anInstance;
+}
+
+vector<Handle(AIS_InteractiveObject)> ShapeInstancer::display(const Handle(AIS_InteractiveContext)& context,
+    const TopoDS_Shape& shp, bool toUpdate)
+{
+    vector<Handle(AIS_InteractiveObject)> displayed;
+    if (shp.IsNull())
+        return displayed;
+
+    vector<TopoDS_Shape> leaves;
+    collectLeaves(shp, leaves);
+    std::map<Key, int> useCount;
+    for (const TopoDS_Shape& leaf : leaves)
+        useCount[keyOf(leaf)]++;
+
+    /* a leaf used once is not worth its own object, they stay in one compound */
+    TopoDS_Compound aCompound;
+    BRep_Builder aBuilder;
+    aBuilder.MakeCompound(aCompound);
+    int nbUnique = 0;
+    for (const TopoDS_Shape& leaf : leaves)
+    {
+        if (useCount[keyOf(leaf)] > 1)
+        {
+            displayed.push_back(instance(leaf));
+            context->Display(displayed.back(), context->DisplayMode(), -1, Standard_False);
+        }
+        else
+        {
+            aBuilder.Add(aCompound, leaf);
+            nbUnique++;
+        }
+    }
+
+    if (displayed.empty())
+    {
+        displayed.push_back(new AIS_Shape(shp));
+        context->Display(displayed.back(), context->DisplayMode(), -1, Standard_False);
+    }
+    else if (nbUnique > 0)
+    {
+        displayed.push_back(new AIS_Shape(aCompound));
+        context->Display(displayed.back(), context->DisplayMode(), -1, Standard_False);
+    }
+    if (toUpdate)
+        context->UpdateCurrentViewer();
+    return displayed;
+}
+
+void ShapeInstancer::release(const TopoDS_Shape& shp)
+{
+    references.erase(keyOf(shp));
+}
+
+void ShapeInstancer::clear()
+{
+    references.clear();
+}
+
+int ShapeInstancer::referenceCount() const
+{
+    return static_cast<int>(references.size());
+}
+
+TopoDS_Shape ShapeInstancer::shapeOf(const Handle(AIS_InteractiveObject)& obj)
+{
+    Handle(AIS_Shape) anAisShape = Handle(AIS_Shape)::DownCast(obj);
+    if (!anAisShape.IsNull())
+        return anAisShape->Shape().Moved(TopLoc_Location(anAisShape->LocalTransformation()));
+
+    Handle(AIS_ConnectedInteractive) anInstance = Handle(AIS_ConnectedInteractive)::DownCast(obj);
+    if (anInstance.IsNull())
+        return TopoDS_Shape();
+    Handle(AIS_Shape) aReference = Handle(AIS_Shape)::DownCast(anInstance->ConnectedTo());
+    if (aReference.IsNull())
+        return TopoDS_Shape();
+    return aReference->Shape().Moved(TopLoc_Location(anInstance->LocalTransformation()));
+}
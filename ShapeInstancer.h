@@ -0,0 +1,51 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <AIS_Shape.hxx>
+#include <AIS_InteractiveContext.hxx>
+#include <TopoDS_Shape.hxx>
+
+using std::vector;
+
+/*
+* ShapeInstancer shows shapes that share a TShape at different locations
+* as AIS_ConnectedInteractive instances of one AIS_Shape. The reference is
+* triangulated, presented and selected once; an instance only adds its
+* own transformation, so memory and draw cost follow the unique parts.
+* References are kept until released, even when no instance is shown.
+*/
+class ShapeInstancer
+{
+public:
+	ShapeInstancer();
+	~ShapeInstancer();
+
+	/* the un-located AIS_Shape of shp, made on first use */
+	Handle(AIS_Shape) reference(const TopoDS_Shape& shp);
+	/* a new instance of shp, connected to its reference at the location of shp */
+	Handle(AIS_InteractiveObject) instance(const TopoDS_Shape& shp);
+
+	/*
+	* display a loaded model: repeated sub-shapes of its compounds become
+	* instances, the rest stays together in one AIS_Shape. No selection
+	* mode is activated, the caller prepares the selection.
+	*/
+	vector<Handle(AIS_InteractiveObject)> display(const Handle(AIS_InteractiveContext)& context,
+		const TopoDS_Shape& shp, bool toUpdate);
+
+	/* forget the reference of shp, once none of its instances is displayed */
+	void release(const TopoDS_Shape& shp);
+	void clear();
+	int referenceCount() const;
+
+	/* located shape of an AIS_Shape or of an instance, null otherwise */
+	static TopoDS_Shape shapeOf(const Handle(AIS_InteractiveObject)& obj);
+
+private:
+	typedef std::pair<const TopoDS_TShape*, TopAbs_Orientation> Key;
+	static Key keyOf(const TopoDS_Shape& shp);
+
+	std::map<Key, Handle(AIS_Shape)> references;
+};
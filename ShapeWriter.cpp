@@ -0,0 +1,118 @@
+#include "ShapeWriter.h"
+#include "Tracer.h"
+#include <chrono>
+#include <cstdio>
+#include <cctype>
+#include <algorithm>
+
+#include <BRepTools.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <BinTools.hxx>
+#include <STEPControl_Writer.hxx>
+#include <Message_ProgressScope.hxx>
+
+typedef std::chrono::steady_clock Clock;
+
+static TopoDS_Shape snapshotOf(const TopoDS_Shape& shp)
+{
+    /* new TShapes over the same surfaces and Poly_Triangulation */
+    if (shp.IsNull())
+        return shp;
+    return BRepBuilderAPI_Copy(shp, Standard_False, Standard_True).Shape();
+}
+
+ShapeWriter::ShapeWriter(const std::string& fileName, const TopoDS_Shape& shp)
+    : fileName(fileName),
+    topoShape(shp),
+    shapeFormat(formatOf(fileName)),
+    progressState(new Progress()),
+    elapsedMs(0.0)
+{
+
+}
+
+ShapeWriter::~ShapeWriter()
+{
+
+}
+
+ShapeFormat ShapeWriter::formatOf(const std::string& fileName)
+{
+    std::string suffix = fileName.substr(fileName.find_last_of('.') + 1);
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (suffix == "stp" || suffix == "step")
+        return ShapeFormat::Step;
+    if (suffix == "bbrep")
+        return ShapeFormat::BinBRep;
+    return ShapeFormat::BRep;
+}
+
+bool ShapeWriter::write()
+{
+    Tracer::Span span("save", "export");
+    Clock::time_point start = Clock::now();
+    topoShape = snapshotOf(topoShape);
+    std::string tmpName = fileName + ".part";
+    bool isDone = !topoShape.IsNull() && writeFile(tmpName);
+
+    if (isDone)
+    {
+        std::remove(fileName.c_str());
+        isDone = std::rename(tmpName.c_str(), fileName.c_str()) == 0;
+    }
+    if (!isDone)
+        std::remove(tmpName.c_str());
+
+    elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return isDone;
+}
+
+bool ShapeWriter::writeFile(const std::string& path)
+{
+    Message_ProgressScope scope(progressState->Start(), "Save", 2);
+    switch (shapeFormat)
+    {
+    case ShapeFormat::Step:
+    {
+        /* transfer is the long part, Write() has no progress of its own */
+        STEPControl_Writer stepWriter;
+        if (stepWriter.Transfer(topoShape, STEPControl_AsIs, Standard_True, scope.Next()) != IFSelect_RetDone
+            || !scope.More())
+            return false;
+        bool isDone = stepWriter.Write(path.c_str()) == IFSelect_RetDone;
+        scope.Next();
+        return isDone;
+    }
+    case ShapeFormat::BinBRep:
+        return BinTools::Write(topoShape, path.c_str(), scope.Next(2)) && scope.More();
+    default:
+        return BRepTools::Write(topoShape, path.c_str(), scope.Next(2)) && scope.More();
+    }
+}
+
+void ShapeWriter::cancel()
+{
+    progressState->cancel();
+}
+
+int ShapeWriter::progress() const
+{
+    return progressState->percent();
+}
+
+const std::string& ShapeWriter::file() const
+{
+    return fileName;
+}
+
+ShapeFormat ShapeWriter::format() const
+{
+    return shapeFormat;
+}
+
+double ShapeWriter::elapsed() const
+{
+    return elapsedMs;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include "Progress.h"
+#include <TopoDS_Shape.hxx>
+
+enum class ShapeFormat
+{
+	Step,
+	BRep,       //text
+	BinBRep     //binary, with triangulations
+};
+
+/*
+* ShapeWriter writes one snapshot of a shape on a worker thread.
+* write() first copies the topology (geometry and triangulations stay
+* shared): meshing sets a new triangulation on the faces it is given,
+* the faces of the copy are only ever read by the writer. cancel() stops
+* the write at the next progress step.
+* The file is written next to the target and renamed over it at the end,
+* an interrupted save never leaves a half written model behind.
+*/
+class ShapeWriter
+{
+public:
+	ShapeWriter(const std::string& fileName, const TopoDS_Shape& shp);
+	~ShapeWriter();
+
+	bool write();
+	void cancel();
+
+	/* 0 ... 100, safe to poll from another thread */
+	int progress() const;
+	const std::string& file() const;
+	ShapeFormat format() const;
+	double elapsed() const;
+
+	/* from the file suffix: .stp/.step, .bbrep, anything else is BRep text */
+	static ShapeFormat formatOf(const std::string& fileName);
+
+private:
+	bool writeFile(const std::string& path);
+
+private:
+	std::string fileName;
+	TopoDS_Shape topoShape;
+	ShapeFormat shapeFormat;
+	Handle(Progress) progressState;
+	double elapsedMs;
+};
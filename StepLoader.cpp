@@ -0,0 +1,315 @@
+#include "StepLoader.h"
+#include "ImportCache.h"
+#include "TaskScheduler.h"
+#include "Tracer.h"
+#include <chrono>
+#include <algorithm>
+
+#include <STEPControl_Reader.hxx>
+#include <TopoDS_Compound.hxx>
+#include <BRep_Builder.hxx>
+#include <BRepBndLib.hxx>
+#include <Bnd_Box.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepPrimAPI_MakeBox.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <TopTools_MapOfShape.hxx>
+#include <TopExp_Explorer.hxx>
+#include <Precision.hxx>
+#include <IMeshTools_Parameters.hxx>
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(const Clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* coarse pass of the streamed display, refined in the post phase */
+static const double coarseFactor = 10.0;
+static const double coarseAngle = 45.0 * M_PI / 180.0;
+
+void LoadStream::push(StreamItem&& item)
+{
+    std::lock_guard<std::mutex> lock(queueLock);
+    items.push_back(std::move(item));
+}
+
+vector<StreamItem> LoadStream::take()
+{
+    std::lock_guard<std::mutex> lock(queueLock);
+    vector<StreamItem> taken;
+    taken.swap(items);
+    return taken;
+}
+
+StepLoader::StepLoader(const std::string& fileName)
+    : fileName(fileName),
+    readStatus(IFSelect_RetVoid),
+    nbRoots(0),
+    nbShapes(0),
+    toMesh(true),
+    deviationCoefficient(0.001),      //Prs3d_Drawer default
+    deviationAngle(20.0 * M_PI / 180.0),
+    useCache(false),
+    fromCache(false)
+{
+
+}
+
+StepLoader::~StepLoader()
+{
+
+}
+
+void StepLoader::setMeshing(bool mesh)
+{
+    toMesh = mesh;
+}
+
+void StepLoader::setDeviation(double coefficient, double angle)
+{
+    deviationCoefficient = coefficient;
+    deviationAngle = angle;
+}
+
+void StepLoader::setCache(bool cache)
+{
+    useCache = cache;
+}
+
+void StepLoader::setStream(const std::shared_ptr<LoadStream>& stream)
+{
+    loadStream = stream;
+}
+
+bool StepLoader::load()
+{
+    Tracer::Span span("load", "load");
+    loadTimings = LoadTimings();
+    topoShape.Nullify();
+    index.reset();
+    pieces.clear();
+    fromCache = false;
+
+    /* cache lookup counts as parse time */
+    Clock::time_point start = Clock::now();
+    std::unique_ptr<ImportCache> cache;
+    QString key;
+    if (useCache)
+    {
+        cache.reset(new ImportCache());
+        key = cache->key(QString::fromUtf8(fileName.c_str()));
+        if (cache->load(key, topoShape, index))
+        {
+            readStatus = IFSelect_RetDone;
+            fromCache = true;
+            loadTimings.parse = elapsedMs(start);
+            return true;
+        }
+    }
+
+    /* parse */
+    Tracer::Span parseSpan("parse", "load");
+    STEPControl_Reader stepReader;  //only load English filename
+    readStatus = stepReader.ReadFile(fileName.c_str());
+    stepReader.PrintCheckLoad(Standard_False, IFSelect_ItemsByEntity);
+    loadTimings.parse = elapsedMs(start);
+    parseSpan.close();
+    if (readStatus != IFSelect_RetDone)
+        return false;
+
+    /* transfer, every root in one pass unless streamed */
+    start = Clock::now();
+    Tracer::Span transferSpan("transfer", "load");
+    nbRoots = stepReader.NbRootsForTransfer();
+    if (loadStream)
+        transferStreamed(stepReader);
+    else
+        stepReader.TransferRoots();
+    nbShapes = stepReader.NbShapes();
+    if (nbShapes == 1)
+    {
+        topoShape = stepReader.Shape(1);
+    }
+    else if (nbShapes > 1)
+    {
+        TopoDS_Compound aCompound;
+        BRep_Builder aBuilder;
+        aBuilder.MakeCompound(aCompound);
+        for (Standard_Integer i = 1; i <= nbShapes; i++)
+        {
+            TopoDS_Shape shp = stepReader.Shape(i);
+            if (!shp.IsNull())
+                aBuilder.Add(aCompound, shp);
+        }
+        topoShape = aCompound;
+    }
+    loadTimings.transfer = elapsedMs(start);
+    transferSpan.arg("shapes", nbShapes);
+    transferSpan.close();
+    if (topoShape.IsNull())
+        return false;
+
+    /* post-process */
+    start = Clock::now();
+    postProcess();
+    if (cache)
+        cache->store(key, topoShape, *index);
+    loadTimings.post = elapsedMs(start);
+
+    return true;
+}
+
+void StepLoader::transferStreamed(STEPControl_Reader& stepReader)
+{
+    /*
+    * roots go one by one through the same transfer process, so entities
+    * shared between roots are still translated once; a file with a single
+    * assembly root streams only after that root is transferred
+    */
+    for (Standard_Integer i = 1; i <= nbRoots; i++)
+    {
+        int nbBefore = stepReader.NbShapes();
+        stepReader.TransferRoot(i);
+
+        size_t first = pieces.size();
+        for (Standard_Integer k = nbBefore + 1; k <= stepReader.NbShapes(); k++)
+        {
+            TopoDS_Shape shp = stepReader.Shape(k);
+            if (shp.IsNull())
+                continue;
+
+            for (TopExp_Explorer exp(shp, TopAbs_SOLID); exp.More(); exp.Next())
+                pieces.push_back(exp.Current());
+
+            /* faces outside any solid make one more piece */
+            TopoDS_Compound aFree;
+            BRep_Builder aBuilder;
+            aBuilder.MakeCompound(aFree);
+            bool hasFree = false;
+            for (TopExp_Explorer exp(shp, TopAbs_FACE, TopAbs_SOLID); exp.More(); exp.Next())
+            {
+                aBuilder.Add(aFree, exp.Current());
+                hasFree = true;
+            }
+            if (hasFree)
+                pieces.push_back(aFree);
+        }
+
+        /* placeholders of the whole root first, then the coarse meshes */
+        for (size_t id = first; id < pieces.size(); id++)
+        {
+            Bnd_Box aBox;
+            BRepBndLib::Add(pieces[id], aBox, Standard_False);
+            if (aBox.IsVoid())
+                continue;
+            aBox.Enlarge(Precision::Confusion());
+            TopoDS_Shape aBoxShape = BRepPrimAPI_MakeBox(aBox.CornerMin(), aBox.CornerMax()).Shape();
+            loadStream->push(StreamItem{ StreamStage::Box, static_cast<int>(id), aBoxShape });
+        }
+        for (size_t id = first; id < pieces.size(); id++)
+        {
+            /* the coarse mesh goes on a copy, the piece is meshed once with the final mesh */
+            TopoDS_Shape aPreview = BRepBuilderAPI_Copy(pieces[id], Standard_False, Standard_False).Shape();
+            if (toMesh)
+            {
+                IMeshTools_Parameters meshParam;
+                meshParam.Deflection = meshDeflection(pieces[id], deviationCoefficient) * coarseFactor;
+                meshParam.Angle = coarseAngle;
+                meshParam.InParallel = TaskScheduler::instance().hasIdleThreads();
+                Tracer::Span meshSpan("coarse mesh", "mesh");
+                BRepMesh_IncrementalMesh mesher(aPreview, meshParam);
+            }
+            loadStream->push(StreamItem{ StreamStage::Coarse, static_cast<int>(id), aPreview });
+        }
+    }
+}
+
+void StepLoader::postProcess()
+{
+    if (loadStream)
+    {
+        /*
+        * mesh piece by piece, the ui swaps each preview for the piece once it
+        * is done; a repeated solid shares the faces of one already pushed and
+        * is not meshed again
+        */
+        TopTools_MapOfShape meshed;
+        for (size_t id = 0; id < pieces.size(); id++)
+        {
+            if (toMesh && meshed.Add(pieces[id].Located(TopLoc_Location())))
+            {
+                IMeshTools_Parameters meshParam;
+                meshParam.Deflection = meshDeflection(pieces[id], deviationCoefficient);
+                meshParam.Angle = deviationAngle;
+                meshParam.InParallel = TaskScheduler::instance().hasIdleThreads();
+                Tracer::Span meshSpan("mesh", "mesh");
+                BRepMesh_IncrementalMesh mesher(pieces[id], meshParam);
+            }
+            loadStream->push(StreamItem{ StreamStage::Fine, static_cast<int>(id), pieces[id] });
+        }
+    }
+    else if (toMesh)
+    {
+        IMeshTools_Parameters meshParam;
+        meshParam.Deflection = meshDeflection(topoShape, deviationCoefficient);
+        meshParam.Angle = deviationAngle;
+        meshParam.InParallel = TaskScheduler::instance().hasIdleThreads();
+        Tracer::Span meshSpan("mesh", "mesh");
+        BRepMesh_IncrementalMesh mesher(topoShape, meshParam);
+    }
+    index = std::make_shared<TopoIndex>(topoShape);
+}
+
+double StepLoader::meshDeflection(const TopoDS_Shape& shp, double coefficient)
+{
+    Bnd_Box aBox;
+    BRepBndLib::Add(shp, aBox, Standard_False);
+    if (aBox.IsVoid())
+        return 0.1;
+
+    gp_XYZ aDiag = aBox.CornerMax().XYZ() - aBox.CornerMin().XYZ();
+    double aSize = std::max(aDiag.X(), std::max(aDiag.Y(), aDiag.Z()));
+    return aSize * coefficient * 4.0;
+}
+
+const TopoDS_Shape& StepLoader::shape() const
+{
+    return topoShape;
+}
+
+std::shared_ptr<TopoIndex> StepLoader::topoIndex() const
+{
+    return index;
+}
+
+bool StepLoader::isFromCache() const
+{
+    return fromCache;
+}
+
+bool StepLoader::isStreamed() const
+{
+    return loadStream && !fromCache;
+}
+
+const LoadTimings& StepLoader::timings() const
+{
+    return loadTimings;
+}
+
+IFSelect_ReturnStatus StepLoader::status() const
+{
+    return readStatus;
+}
+
+int StepLoader::rootCount() const
+{
+    return nbRoots;
+}
+
+int StepLoader::shapeCount() const
+{
+    return nbShapes;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include "TopoIndex.h"
+#include <TopoDS_Shape.hxx>
+#include <IFSelect_ReturnStatus.hxx>
+
+class STEPControl_Reader;
+
+/* wall time of each load phase in milliseconds */
+struct LoadTimings
+{
+	double parse = 0.0;
+	double transfer = 0.0;
+	double post = 0.0;
+
+	double total() const { return parse + transfer + post; }
+};
+
+/*
+* streamed display stages of one piece (a solid, or the free faces of a root):
+* a box placeholder, then a coarse mesh, then the final mesh
+*/
+enum class StreamStage
+{
+	Box,
+	Coarse,
+	Fine
+};
+
+/*
+* the shape of an item is the loader's last word on it: a box, a meshed
+* copy of the piece (Coarse) or the piece itself with its final mesh (Fine)
+*/
+struct StreamItem
+{
+	StreamStage stage;
+	int id;
+	TopoDS_Shape shape;
+};
+
+/*
+* LoadStream hands pieces from the loader thread to the ui, which takes
+* the queued items once per tick. The loader never meshes a shape after
+* it is pushed, so the ui reads the triangulations without a lock.
+*/
+class LoadStream
+{
+public:
+	void push(StreamItem&& item);
+	vector<StreamItem> take();
+
+private:
+	std::mutex queueLock;
+	vector<StreamItem> items;
+};
+
+/*
+* StepLoader reads a STEP file and keeps every transferred root in one
+* compound. Phases:
+*   parse     ReadFile into the STEP model
+*   transfer  TransferRoots, one pass over all roots so shared entities
+*             are translated once
+*   post      mesh the result in parallel with the deflection AIS would
+*             ask for, so display does not triangulate on the ui thread,
+*             and build the TopoIndex
+* With a LoadStream set, roots are transferred one by one and every solid
+* is pushed as soon as it exists: box placeholder first, then a coarsely
+* meshed copy, and in the post phase the solid itself with the final mesh.
+* With the cache on, a file seen before is read back from ImportCache
+* (shape, triangulations and index) and parse/transfer are skipped.
+*/
+class StepLoader
+{
+public:
+	/* fileName is utf-8 */
+	explicit StepLoader(const std::string& fileName);
+	~StepLoader();
+
+	bool load();
+
+	void setMeshing(bool toMesh);
+	void setDeviation(double coefficient, double angle);
+	void setCache(bool useCache);
+	void setStream(const std::shared_ptr<LoadStream>& stream);
+
+	const TopoDS_Shape& shape() const;
+	std::shared_ptr<TopoIndex> topoIndex() const;
+	bool isFromCache() const;
+	bool isStreamed() const;
+	const LoadTimings& timings() const;
+	IFSelect_ReturnStatus status() const;
+	int rootCount() const;
+	int shapeCount() const;
+
+	/* deflection matching StdPrs_ToolTriangulatedShape::GetDeflection */
+	static double meshDeflection(const TopoDS_Shape& shp, double coefficient);
+
+private:
+	void transferStreamed(STEPControl_Reader& stepReader);
+	void postProcess();
+
+private:
+	std::string fileName;
+	TopoDS_Shape topoShape;
+	std::shared_ptr<TopoIndex> index;
+	LoadTimings loadTimings;
+	IFSelect_ReturnStatus readStatus;
+	int nbRoots;
+	int nbShapes;
+
+	bool toMesh;
+	double deviationCoefficient;
+	double deviationAngle;
+	bool useCache;
+	bool fromCache;
+
+	std::shared_ptr<LoadStream> loadStream;
+	vector<TopoDS_Shape> pieces;
+};
@@ -0,0 +1,320 @@
+#include "TaskScheduler.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <QtGlobal>
+#include <OSD_ThreadPool.hxx>
+
+/* index of the worker running on this thread, -1 elsewhere */
+static thread_local int workerIndex = -1;
+
+CancelToken::CancelToken() : flag(std::make_shared<std::atomic<bool>>(false))
+{
+
+}
+
+void CancelToken::cancel()
+{
+    *flag = true;
+}
+
+bool CancelToken::isCancelled() const
+{
+    return *flag;
+}
+
+TaskGroup::TaskGroup() : pending(0)
+{
+
+}
+
+TaskGroup::~TaskGroup()
+{
+    /* the tasks reference the group, it must not go before them */
+    if (pending > 0)
+    {
+        try
+        {
+            wait();
+        }
+        catch (...)
+        {
+        }
+    }
+}
+
+void TaskGroup::wait()
+{
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    while (pending > 0)
+    {
+        TaskScheduler::Task task;
+        if (scheduler.take(task, this))
+        {
+            scheduler.execute(task);
+            continue;
+        }
+
+        /* nothing of the group is queued any more, the rest runs on other threads */
+        std::unique_lock<std::mutex> lock(doneLock);
+        done.wait(lock, [this]() { return pending == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(errorLock);
+    if (error)
+    {
+        std::exception_ptr anError = error;
+        error = nullptr;
+        std::rethrow_exception(anError);
+    }
+}
+
+TaskScheduler& TaskScheduler::instance()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler() : nbWorkers(0), nbQueued(0), nbBusy(0), toStop(false), toDrain(false)
+{
+    /* QCC_THREADS overrides the default of one worker per core */
+    start(qEnvironmentVariableIntValue("QCC_THREADS"));
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    dropBackground();
+    stop(true);
+}
+
+void TaskScheduler::setThreadCount(int nbThreads)
+{
+    if (nbThreads == threadCount())
+        return;
+
+    stop(false);
+    /* the old workers' queues go to the shared one, nothing is lost */
+    std::lock_guard<std::mutex> pool(poolLock);
+    {
+        std::lock_guard<std::mutex> lock(sharedLock);
+        for (std::unique_ptr<Worker>& aWorker : workers)
+        {
+            for (int p = 0; p < static_cast<int>(TaskPriority::NbPriorities); p++)
+                shared[p].insert(shared[p].end(), aWorker->queues[p].begin(), aWorker->queues[p].end());
+        }
+    }
+    start(nbThreads);
+}
+
+int TaskScheduler::threadCount() const
+{
+    return nbWorkers;
+}
+
+bool TaskScheduler::hasIdleThreads() const
+{
+    return nbBusy < threadCount() && nbQueued == 0;
+}
+
+bool TaskScheduler::isWorker()
+{
+    return workerIndex >= 0;
+}
+
+void TaskScheduler::start(int nbThreads)
+{
+    if (nbThreads <= 0)
+        nbThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    toStop = false;
+    toDrain = false;
+    workers.clear();
+    for (int i = 0; i < nbThreads; i++)
+        workers.emplace_back(new Worker());
+    nbWorkers = nbThreads;
+    for (int i = 0; i < nbThreads; i++)
+        workers[i]->thread = std::thread(&TaskScheduler::workerLoop, this, i);
+
+    /* OCCT's own pool, used by the mesher, gets no more threads than we have */
+    OSD_ThreadPool::DefaultPool()->Init(nbThreads);
+}
+
+void TaskScheduler::stop(bool drain)
+{
+    {
+        std::lock_guard<std::mutex> lock(sharedLock);
+        toDrain = drain;
+        toStop = true;
+    }
+    wakeUp.notify_all();
+    for (std::unique_ptr<Worker>& aWorker : workers)
+    {
+        if (aWorker->thread.joinable())
+            aWorker->thread.join();
+    }
+}
+
+void TaskScheduler::dropBackground()
+{
+    const int p = static_cast<int>(TaskPriority::Background);
+    auto drop = [this](std::deque<Task>& queue) {
+        for (Task& task : queue)
+        {
+            if (task.group)
+            {
+                std::lock_guard<std::mutex> lock(task.group->doneLock);
+                if (--task.group->pending == 0)
+                    task.group->done.notify_all();
+            }
+        }
+        nbQueued -= static_cast<int>(queue.size());
+        queue.clear();
+    };
+
+    std::lock_guard<std::mutex> pool(poolLock);
+    for (std::unique_ptr<Worker>& aWorker : workers)
+    {
+        std::lock_guard<std::mutex> lock(aWorker->lock);
+        drop(aWorker->queues[p]);
+    }
+    std::lock_guard<std::mutex> lock(sharedLock);
+    drop(shared[p]);
+}
+
+void TaskScheduler::post(std::function<void()> fn, TaskPriority priority, TaskGroup* group)
+{
+    if (group)
+        group->pending++;
+
+    Task task{ std::move(fn), group };
+    const int p = static_cast<int>(priority);
+    /* a worker keeps what it spawns, the others may steal it */
+    if (isWorker() && workerIndex < threadCount())
+    {
+        Worker& aWorker = *workers[workerIndex];
+        std::lock_guard<std::mutex> lock(aWorker.lock);
+        aWorker.queues[p].push_back(std::move(task));
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(sharedLock);
+        shared[p].push_back(std::move(task));
+    }
+    nbQueued++;
+
+    /* under the lock, so a worker about to sleep can not miss it */
+    std::lock_guard<std::mutex> lock(sharedLock);
+    wakeUp.notify_one();
+}
+
+bool TaskScheduler::take(Task& task, const TaskGroup* group)
+{
+    auto matches = [group](const Task& t) { return group == NULL || t.group == group; };
+    const int self = workerIndex < threadCount() ? workerIndex : -1;
+
+    /* the workers are only replaced while none runs, any other thread must hold the pool */
+    std::unique_lock<std::mutex> pool(poolLock, std::defer_lock);
+    if (!isWorker())
+        pool.lock();
+
+    for (int p = static_cast<int>(TaskPriority::NbPriorities) - 1; p >= 0; p--)
+    {
+        /* own tasks newest first, they are the ones still in cache */
+        if (self >= 0)
+        {
+            Worker& aWorker = *workers[self];
+            std::lock_guard<std::mutex> lock(aWorker.lock);
+            std::deque<Task>& queue = aWorker.queues[p];
+            for (auto it = queue.rbegin(); it != queue.rend(); ++it)
+            {
+                if (matches(*it))
+                {
+                    task = std::move(*it);
+                    queue.erase(std::next(it).base());
+                    nbQueued--;
+                    return true;
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(sharedLock);
+            std::deque<Task>& queue = shared[p];
+            auto it = std::find_if(queue.begin(), queue.end(), matches);
+            if (it != queue.end())
+            {
+                task = std::move(*it);
+                queue.erase(it);
+                nbQueued--;
+                return true;
+            }
+        }
+
+        /* steal the oldest task of another worker */
+        for (int i = 0; i < threadCount(); i++)
+        {
+            if (i == self)
+                continue;
+            Worker& aVictim = *workers[i];
+            std::lock_guard<std::mutex> lock(aVictim.lock);
+            std::deque<Task>& queue = aVictim.queues[p];
+            auto it = std::find_if(queue.begin(), queue.end(), matches);
+            if (it != queue.end())
+            {
+                task = std::move(*it);
+                queue.erase(it);
+                nbQueued--;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::execute(Task& task)
+{
+    nbBusy++;
+    Tracer::count("tasks");
+    try
+    {
+        task.fn();
+    }
+    catch (...)
+    {
+        if (task.group)
+        {
+            std::lock_guard<std::mutex> lock(task.group->errorLock);
+            if (!task.group->error)
+                task.group->error = std::current_exception();
+        }
+    }
+    nbBusy--;
+    if (task.group)
+    {
+        /* under the lock, the waiter may destroy the group as soon as it sees 0 */
+        std::lock_guard<std::mutex> lock(task.group->doneLock);
+        if (--task.group->pending == 0)
+            task.group->done.notify_all();
+    }
+}
+
+void TaskScheduler::workerLoop(int index)
+{
+    workerIndex = index;
+    Tracer::setThreadName("worker " + std::to_string(index));
+    for (;;)
+    {
+        /* a new thread count leaves the queued tasks to the next workers, exit runs them */
+        Task task;
+        if ((!toStop || toDrain) && take(task, NULL))
+        {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sharedLock);
+        wakeUp.wait(lock, [this]() { return toStop || nbQueued > 0; });
+        if (toStop)
+            break;
+    }
+    workerIndex = -1;
+}
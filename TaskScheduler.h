@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+#include <QFuture>
+#include <QFutureInterface>
+
+using std::vector;
+
+/* workers always take the highest priority task that is queued */
+enum class TaskPriority
+{
+	Background,   //batch jobs
+	Normal,       //import, export, analysis
+	Interactive,  //what the user waits for: meshing, obb, selection
+	NbPriorities
+};
+
+/*
+* CancelToken is shared by copy: every copy sees cancel(). A task whose
+* token is cancelled before it starts is dropped, a running one polls it.
+*/
+class CancelToken
+{
+public:
+	CancelToken();
+
+	void cancel();
+	bool isCancelled() const;
+
+private:
+	std::shared_ptr<std::atomic<bool>> flag;
+};
+
+/* tasks spawned together, wait() returns when all of them are done */
+class TaskGroup
+{
+public:
+	TaskGroup();
+	~TaskGroup();
+
+	/*
+	* helps with the group's own queued tasks while it waits, sleeps once the
+	* rest runs on other threads; rethrows the first exception
+	*/
+	void wait();
+
+private:
+	friend class TaskScheduler;
+	std::atomic<int> pending;
+	std::mutex doneLock;
+	std::condition_variable done;  //pending reached 0
+	std::mutex errorLock;
+	std::exception_ptr error;
+};
+
+/*
+* TaskScheduler is the one worker pool of the application. Each worker
+* has its own deque per priority: it pushes and pops at the back and the
+* others steal from the front, tasks posted from outside go to a shared
+* queue. A task runs to its end, so interactive work gets the next free
+* worker rather than interrupting a batch task; parallelFor splits loops
+* into chunks small enough for that to happen quickly.
+* Nested parallelism adds no threads: a thread waiting on a group runs
+* that group's tasks itself. At exit the queued Background tasks are
+* dropped, the others still run.
+*/
+class TaskScheduler
+{
+public:
+	static TaskScheduler& instance();
+
+	/* 0 is one per core; running tasks finish, queued ones are kept. Not from a worker */
+	void setThreadCount(int nbThreads);
+	int threadCount() const;
+	/* whether an OCCT algorithm may use its own parallel mode without oversubscribing */
+	bool hasIdleThreads() const;
+	static bool isWorker();
+
+	void post(std::function<void()> fn, TaskPriority priority = TaskPriority::Normal,
+		TaskGroup* group = NULL);
+
+	/* fn(i) for i in [begin, end), the caller takes part; stops early when token is cancelled */
+	template <typename F>
+	void parallelFor(int begin, int end, F fn, TaskPriority priority = TaskPriority::Normal,
+		const CancelToken& token = CancelToken());
+
+	/* fn() on a worker, the future is cancelled if the token is before it starts or fn throws */
+	template <typename F>
+	auto run(F fn, TaskPriority priority = TaskPriority::Normal,
+		const CancelToken& token = CancelToken()) -> QFuture<decltype(fn())>;
+
+private:
+	struct Task
+	{
+		std::function<void()> fn;
+		TaskGroup* group;
+	};
+	struct Worker
+	{
+		std::thread thread;
+		std::mutex lock;
+		std::deque<Task> queues[static_cast<int>(TaskPriority::NbPriorities)];
+	};
+
+	TaskScheduler();
+	~TaskScheduler();
+	TaskScheduler(const TaskScheduler&) = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+	void start(int nbThreads);
+	/* the workers finish their running task; with drain they run the queued ones first */
+	void stop(bool drain);
+	/* Background tasks still queued at exit, loads and exports nobody waits for */
+	void dropBackground();
+	void workerLoop(int index);
+	/* a queued task of group, of any group if NULL; the highest priority first */
+	bool take(Task& task, const TaskGroup* group);
+	void execute(Task& task);
+	friend class TaskGroup;
+
+	vector<std::unique_ptr<Worker>> workers;  //changed with no worker running, under poolLock
+	std::mutex poolLock;                      //other threads steal from workers under it
+	std::atomic<int> nbWorkers;
+	std::deque<Task> shared[static_cast<int>(TaskPriority::NbPriorities)];
+	mutable std::mutex sharedLock;
+	std::condition_variable wakeUp;
+	std::atomic<int> nbQueued;
+	std::atomic<int> nbBusy;
+	std::atomic<bool> toStop;
+	std::atomic<bool> toDrain;
+};
+
+namespace TaskDetail
+{
+	template <typename R, typename F>
+	void fulfil(QFutureInterface<R>& promise, F& fn)
+	{
+		R result = fn();
+		promise.reportResult(result);
+	}
+
+	template <typename F>
+	void fulfil(QFutureInterface<void>&, F& fn)
+	{
+		fn();
+	}
+}
+
+template <typename F>
+void TaskScheduler::parallelFor(int begin, int end, F fn, TaskPriority priority, const CancelToken& token)
+{
+	if (end <= begin)
+		return;
+
+	/* a few chunks per thread balance uneven items without a task per item */
+	const int nbItems = end - begin;
+	const int nbChunks = std::min(nbItems, std::max(1, threadCount()) * 4);
+	const int chunkSize = (nbItems + nbChunks - 1) / nbChunks;
+
+	TaskGroup group;
+	for (int from = begin + chunkSize; from < end; from += chunkSize)
+	{
+		const int to = std::min(end, from + chunkSize);
+		post([&fn, &token, from, to]() {
+			for (int i = from; i < to && !token.isCancelled(); i++)
+				fn(i);
+		}, priority, &group);
+	}
+
+	/* the first chunk on the calling thread, then help with the rest */
+	std::exception_ptr error;
+	try
+	{
+		for (int i = begin; i < std::min(end, begin + chunkSize) && !token.isCancelled(); i++)
+			fn(i);
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+	group.wait();
+	if (error)
+		std::rethrow_exception(error);
+}
+
+template <typename F>
+auto TaskScheduler::run(F fn, TaskPriority priority, const CancelToken& token) -> QFuture<decltype(fn())>
+{
+	typedef decltype(fn()) R;
+	std::shared_ptr<QFutureInterface<R>> promise = std::make_shared<QFutureInterface<R>>();
+	promise->reportStarted();
+	QFuture<R> future = promise->future();
+
+	post([promise, fn, token]() mutable {
+		if (token.isCancelled() || promise->isCanceled())
+		{
+			promise->reportCanceled();
+			promise->reportFinished();
+			return;
+		}
+		try
+		{
+			TaskDetail::fulfil(*promise, fn);
+		}
+		catch (...)
+		{
+			promise->reportCanceled();
+		}
+		promise->reportFinished();
+	}, priority);
+	return future;
+}
@@ -0,0 +1,392 @@
+#include "TopoIndex.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cstdint>
+
+#include <TopoDS.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TopExp_Explorer.hxx>
+
+static void appendUnique(TopoAdjacency& adj, vector<int>& ids)
+{
+    /* seam edges and closed edges show up twice, keep one id */
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    adj.ids.insert(adj.ids.end(), ids.begin(), ids.end());
+    adj.offsets.push_back(static_cast<int>(adj.ids.size()));
+}
+
+TopoRange TopoAdjacency::at(int i) const
+{
+    const int* data = ids.data();
+    return TopoRange{ data + offsets[i], data + offsets[i + 1] };
+}
+
+void TopoAdjacency::clear()
+{
+    offsets.assign(1, 0);
+    ids.clear();
+}
+
+TopoIndex::TopoIndex()
+{
+    clear();
+}
+
+TopoIndex::TopoIndex(const TopoDS_Shape& topoShp)
+{
+    Tracer::Span span("topology index", "analysis");
+    build(topoShp);
+}
+
+TopoIndex::~TopoIndex()
+{
+
+}
+
+void TopoIndex::clear()
+{
+    topoShape.Nullify();
+    solidMap.Clear();
+    faceMap.Clear();
+    edgeMap.Clear();
+    vertexMap.Clear();
+
+    solidFaceAdj.clear();
+    faceSolidAdj.clear();
+    faceEdgeAdj.clear();
+    edgeFaceAdj.clear();
+    edgeVertexAdj.clear();
+    vertexEdgeAdj.clear();
+}
+
+bool TopoIndex::isEmpty() const
+{
+    return faceMap.IsEmpty() && edgeMap.IsEmpty() && vertexMap.IsEmpty();
+}
+
+void TopoIndex::build(const TopoDS_Shape& topoShp)
+{
+    walk(topoShp, true);
+}
+
+void TopoIndex::walk(const TopoDS_Shape& topoShp, bool withAdjacency)
+{
+    clear();
+    topoShape = topoShp;
+    if (topoShp.IsNull())
+        return;
+
+    /*
+    * one walk over the shape: every sub-shape is hashed once when it gets
+    * its id, and its downward adjacency is appended right away, so the
+    * csr rows come out in id order without any sorting pass
+    */
+    vector<TopoDS_Shape> stack{ topoShp };
+    vector<int> faceIds, edgeIds, vertexIds;
+    int curSolid = -1;
+    size_t solidDepth = 0;
+
+    /* reversed, so the children pop in their own order as TopExp_Explorer visits them */
+    auto pushChildren = [&stack](const TopoDS_Shape& shp)
+    {
+        size_t first = stack.size();
+        for (TopoDS_Iterator it(shp); it.More(); it.Next())
+            stack.push_back(it.Value());
+        std::reverse(stack.begin() + first, stack.end());
+    };
+
+    auto addVertex = [&](const TopoDS_Shape& shp) -> int
+    {
+        return vertexMap.Add(shp) - 1;
+    };
+
+    auto addEdge = [&](const TopoDS_Shape& shp) -> int
+    {
+        int id = edgeMap.FindIndex(shp);
+        if (id > 0)
+            return id - 1;
+
+        id = edgeMap.Add(shp) - 1;
+        vertexIds.clear();
+        for (TopoDS_Iterator it(shp); it.More(); it.Next())
+        {
+            if (it.Value().ShapeType() == TopAbs_VERTEX)
+                vertexIds.push_back(addVertex(it.Value()));
+        }
+        if (withAdjacency)
+            appendUnique(edgeVertexAdj, vertexIds);
+        return id;
+    };
+
+    auto addFace = [&](const TopoDS_Shape& shp) -> int
+    {
+        int id = faceMap.FindIndex(shp);
+        if (id > 0)
+            return id - 1;
+
+        id = faceMap.Add(shp) - 1;
+        edgeIds.clear();
+        for (TopExp_Explorer exp(shp, TopAbs_EDGE); exp.More(); exp.Next())
+        {
+            edgeIds.push_back(addEdge(exp.Current()));
+        }
+        /* vertices hanging in the face without an edge */
+        for (TopExp_Explorer exp(shp, TopAbs_VERTEX, TopAbs_EDGE); exp.More(); exp.Next())
+        {
+            addVertex(exp.Current());
+        }
+        if (withAdjacency)
+            appendUnique(faceEdgeAdj, edgeIds);
+        return id;
+    };
+
+    auto closeSolid = [&]()
+    {
+        if (withAdjacency)
+            appendUnique(solidFaceAdj, faceIds);
+        curSolid = -1;
+    };
+
+    while (!stack.empty())
+    {
+        /* a solid is closed once the walk is back above its sub-shapes */
+        if (curSolid >= 0 && stack.size() <= solidDepth)
+            closeSolid();
+
+        TopoDS_Shape shp = stack.back();
+        stack.pop_back();
+
+        switch (shp.ShapeType())
+        {
+        case TopAbs_SOLID:
+        {
+            if (solidMap.Contains(shp))
+                break;
+            curSolid = solidMap.Add(shp) - 1;
+            solidDepth = stack.size();
+            faceIds.clear();
+            pushChildren(shp);
+            break;
+        }
+        case TopAbs_FACE:
+        {
+            int id = addFace(shp);
+            if (curSolid >= 0)
+                faceIds.push_back(id);
+            break;
+        }
+        case TopAbs_EDGE:
+            addEdge(shp);
+            break;
+        case TopAbs_VERTEX:
+            addVertex(shp);
+            break;
+        default:
+        {   //compound, compsolid, shell and free wire
+            pushChildren(shp);
+            break;
+        }
+        }
+    }
+    if (curSolid >= 0)
+        closeSolid();
+    if (!withAdjacency)
+        return;
+
+    /* upward adjacency is the transpose of the downward one */
+    transpose(solidFaceAdj, faceCount(), faceSolidAdj);
+    transpose(faceEdgeAdj, edgeCount(), edgeFaceAdj);
+    transpose(edgeVertexAdj, vertexCount(), vertexEdgeAdj);
+}
+
+void TopoIndex::transpose(const TopoAdjacency& src, int nbDst, TopoAdjacency& dst)
+{
+    /* counting sort by destination id, rows stay sorted by source id */
+    dst.offsets.assign(nbDst + 1, 0);
+    for (int id : src.ids)
+        dst.offsets[id + 1]++;
+    for (int i = 0; i < nbDst; i++)
+        dst.offsets[i + 1] += dst.offsets[i];
+
+    dst.ids.resize(src.ids.size());
+    vector<int> fill(dst.offsets.begin(), dst.offsets.end() - 1);
+    int nbSrc = static_cast<int>(src.offsets.size()) - 1;
+    for (int i = 0; i < nbSrc; i++)
+    {
+        for (int k = src.offsets[i]; k < src.offsets[i + 1]; k++)
+            dst.ids[fill[src.ids[k]]++] = i;
+    }
+}
+
+const TopoDS_Shape& TopoIndex::shape() const
+{
+    return topoShape;
+}
+
+int TopoIndex::solidCount() const
+{
+    return solidMap.Extent();
+}
+
+int TopoIndex::faceCount() const
+{
+    return faceMap.Extent();
+}
+
+int TopoIndex::edgeCount() const
+{
+    return edgeMap.Extent();
+}
+
+int TopoIndex::vertexCount() const
+{
+    return vertexMap.Extent();
+}
+
+int TopoIndex::solidId(const TopoDS_Shape& solid) const
+{
+    return solidMap.FindIndex(solid) - 1;
+}
+
+int TopoIndex::faceId(const TopoDS_Shape& face) const
+{
+    return faceMap.FindIndex(face) - 1;
+}
+
+int TopoIndex::edgeId(const TopoDS_Shape& edge) const
+{
+    return edgeMap.FindIndex(edge) - 1;
+}
+
+int TopoIndex::vertexId(const TopoDS_Shape& vertex) const
+{
+    return vertexMap.FindIndex(vertex) - 1;
+}
+
+const TopoDS_Solid& TopoIndex::solid(int id) const
+{
+    return TopoDS::Solid(solidMap.FindKey(id + 1));
+}
+
+const TopoDS_Face& TopoIndex::face(int id) const
+{
+    return TopoDS::Face(faceMap.FindKey(id + 1));
+}
+
+const TopoDS_Edge& TopoIndex::edge(int id) const
+{
+    return TopoDS::Edge(edgeMap.FindKey(id + 1));
+}
+
+const TopoDS_Vertex& TopoIndex::vertex(int id) const
+{
+    return TopoDS::Vertex(vertexMap.FindKey(id + 1));
+}
+
+TopoRange TopoIndex::solidFaces(int solidId) const
+{
+    return solidFaceAdj.at(solidId);
+}
+
+TopoRange TopoIndex::faceSolids(int faceId) const
+{
+    return faceSolidAdj.at(faceId);
+}
+
+TopoRange TopoIndex::faceEdges(int faceId) const
+{
+    return faceEdgeAdj.at(faceId);
+}
+
+TopoRange TopoIndex::edgeFaces(int edgeId) const
+{
+    return edgeFaceAdj.at(edgeId);
+}
+
+TopoRange TopoIndex::edgeVertices(int edgeId) const
+{
+    return edgeVertexAdj.at(edgeId);
+}
+
+TopoRange TopoIndex::vertexEdges(int vertexId) const
+{
+    return vertexEdgeAdj.at(vertexId);
+}
+
+TopTools_ListOfShape TopoIndex::edgeFaceList(int edgeId) const
+{
+    TopTools_ListOfShape faces;
+    for (int f : edgeFaces(edgeId))
+        faces.Append(face(f));
+    return faces;
+}
+
+static void writeAdjacency(std::ostream& out, const TopoAdjacency& adj)
+{
+    int32_t sizes[2] = { static_cast<int32_t>(adj.offsets.size()), static_cast<int32_t>(adj.ids.size()) };
+    out.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    out.write(reinterpret_cast<const char*>(adj.offsets.data()), sizes[0] * sizeof(int));
+    out.write(reinterpret_cast<const char*>(adj.ids.data()), sizes[1] * sizeof(int));
+}
+
+static bool readAdjacency(std::istream& in, TopoAdjacency& adj, int nbRows, int nbCols)
+{
+    int32_t sizes[2] = { 0, 0 };
+    in.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+    if (!in || sizes[0] != nbRows + 1 || sizes[1] < 0)
+        return false;
+
+    adj.offsets.resize(sizes[0]);
+    adj.ids.resize(sizes[1]);
+    in.read(reinterpret_cast<char*>(adj.offsets.data()), sizes[0] * sizeof(int));
+    in.read(reinterpret_cast<char*>(adj.ids.data()), sizes[1] * sizeof(int));
+    if (!in || adj.offsets.front() != 0 || adj.offsets.back() != sizes[1])
+        return false;
+
+    /* a stale or damaged entry must not index out of the maps */
+    for (int i = 0; i < nbRows; i++)
+    {
+        if (adj.offsets[i] > adj.offsets[i + 1])
+            return false;
+    }
+    for (int id : adj.ids)
+    {
+        if (id < 0 || id >= nbCols)
+            return false;
+    }
+    return true;
+}
+
+void TopoIndex::write(std::ostream& out) const
+{
+    int32_t counts[4] = { solidCount(), faceCount(), edgeCount(), vertexCount() };
+    out.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+    writeAdjacency(out, solidFaceAdj);
+    writeAdjacency(out, faceSolidAdj);
+    writeAdjacency(out, faceEdgeAdj);
+    writeAdjacency(out, edgeFaceAdj);
+    writeAdjacency(out, edgeVertexAdj);
+    writeAdjacency(out, vertexEdgeAdj);
+}
+
+bool TopoIndex::read(const TopoDS_Shape& topoShp, std::istream& in)
+{
+    /* the walk gives the same ids as build(), the csr arrays come from the stream */
+    walk(topoShp, false);
+
+    int32_t counts[4] = { 0, 0, 0, 0 };
+    in.read(reinterpret_cast<char*>(counts), sizeof(counts));
+    bool isOk = in && counts[0] == solidCount() && counts[1] == faceCount()
+        && counts[2] == edgeCount() && counts[3] == vertexCount()
+        && readAdjacency(in, solidFaceAdj, solidCount(), faceCount())
+        && readAdjacency(in, faceSolidAdj, faceCount(), solidCount())
+        && readAdjacency(in, faceEdgeAdj, faceCount(), edgeCount())
+        && readAdjacency(in, edgeFaceAdj, edgeCount(), faceCount())
+        && readAdjacency(in, edgeVertexAdj, edgeCount(), vertexCount())
+        && readAdjacency(in, vertexEdgeAdj, vertexCount(), edgeCount());
+
+    if (!isOk)
+        clear();
+    return isOk;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+#include <iostream>
+#include <TopoDS_Shape.hxx>
+#include <TopoDS_Solid.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Edge.hxx>
+#include <TopoDS_Vertex.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TopTools_ListOfShape.hxx>
+
+using std::vector;
+
+/*
+* ids adjacent to one item, [first, last) in the csr array
+*/
+struct TopoRange
+{
+	const int* first;
+	const int* last;
+
+	const int* begin() const { return first; }
+	const int* end() const { return last; }
+	int size() const { return static_cast<int>(last - first); }
+	bool empty() const { return first == last; }
+	int operator[](int i) const { return first[i]; }
+};
+
+/*
+* compressed sparse row adjacency: the ids adjacent to item i
+* are ids[offsets[i]] ... ids[offsets[i + 1] - 1]
+*/
+struct TopoAdjacency
+{
+	vector<int> offsets;
+	vector<int> ids;
+
+	TopoRange at(int i) const;
+	void clear();
+};
+
+/*
+* TopoIndex is built once per loaded shape. Solids, faces, edges and
+* vertices get 0-based integer ids in the order of TopExp::MapShapes
+* (a vertex lying in a face outside any edge comes after the face's
+* edges), all the analysis queries run on the csr arrays instead of
+* rehashing the shape again.
+*/
+class TopoIndex
+{
+public:
+	TopoIndex();
+	explicit TopoIndex(const TopoDS_Shape& topoShp);
+	~TopoIndex();
+
+	void build(const TopoDS_Shape& topoShp);
+	void clear();
+	bool isEmpty() const;
+
+	/* raw csr arrays, read() checks them against a walk of the shape and is empty when they do not fit */
+	void write(std::ostream& out) const;
+	bool read(const TopoDS_Shape& topoShp, std::istream& in);
+
+	const TopoDS_Shape& shape() const;
+	int solidCount() const;
+	int faceCount() const;
+	int edgeCount() const;
+	int vertexCount() const;
+
+	/* id of a sub-shape, -1 if it is not in this shape */
+	int solidId(const TopoDS_Shape& solid) const;
+	int faceId(const TopoDS_Shape& face) const;
+	int edgeId(const TopoDS_Shape& edge) const;
+	int vertexId(const TopoDS_Shape& vertex) const;
+
+	const TopoDS_Solid& solid(int id) const;
+	const TopoDS_Face& face(int id) const;
+	const TopoDS_Edge& edge(int id) const;
+	const TopoDS_Vertex& vertex(int id) const;
+
+	TopoRange solidFaces(int solidId) const;
+	TopoRange faceSolids(int faceId) const;
+	TopoRange faceEdges(int faceId) const;
+	TopoRange edgeFaces(int edgeId) const;
+	TopoRange edgeVertices(int edgeId) const;
+	TopoRange vertexEdges(int vertexId) const;
+
+	/* faces sharing the edge as a shape list, for the Hand:: helpers */
+	TopTools_ListOfShape edgeFaceList(int edgeId) const;
+
+private:
+	void walk(const TopoDS_Shape& topoShp, bool withAdjacency);
+	static void transpose(const TopoAdjacency& src, int nbDst, TopoAdjacency& dst);
+
+private:
+	TopoDS_Shape topoShape;
+	TopTools_IndexedMapOfShape solidMap;
+	TopTools_IndexedMapOfShape faceMap;
+	TopTools_IndexedMapOfShape edgeMap;
+	TopTools_IndexedMapOfShape vertexMap;
+
+	TopoAdjacency solidFaceAdj;
+	TopoAdjacency faceSolidAdj;
+	TopoAdjacency faceEdgeAdj;
+	TopoAdjacency edgeFaceAdj;
+	TopoAdjacency edgeVertexAdj;
+	TopoAdjacency vertexEdgeAdj;
+};
@@ -0,0 +1,180 @@
+#include "Tracer.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdio>
+#include <utility>
+
+using std::vector;
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        const char* category;
+        char phase;       //'X' complete, 'C' counter
+        long long ts;
+        long long dur;
+        const char* argName;
+        double argValue;
+    };
+
+    struct ThreadBuffer
+    {
+        int tid;
+        std::string threadName;
+        std::mutex lock;  //only contended while the trace is written
+        vector<Event> events;
+        vector<std::pair<const char*, double>> counters;
+    };
+
+    /* buffers outlive their threads, a worker's events are written after it stopped */
+    std::mutex registryLock;
+    vector<std::shared_ptr<ThreadBuffer>> buffers;
+    thread_local std::shared_ptr<ThreadBuffer> localBuffer;
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    ThreadBuffer& threadBuffer()
+    {
+        if (!localBuffer)
+        {
+            localBuffer = std::make_shared<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(registryLock);
+            localBuffer->tid = static_cast<int>(buffers.size()) + 1;
+            buffers.push_back(localBuffer);
+        }
+        return *localBuffer;
+    }
+
+    /* names are literals of this program, only quotes and backslashes need care */
+    void writeString(FILE* file, const char* str)
+    {
+        fputc('"', file);
+        for (const char* c = str; *c; c++)
+        {
+            if (*c == '"' || *c == '\\')
+                fputc('\\', file);
+            fputc(*c, file);
+        }
+        fputc('"', file);
+    }
+}
+
+std::atomic<bool> Tracer::enabled(false);
+
+void Tracer::Span::close()
+{
+    if (start < 0)
+        return;
+    Tracer::complete(name, category, start, Tracer::now(), argName, argValue);
+    start = -1;
+}
+
+void Tracer::setEnabled(bool isOn)
+{
+    enabled = isOn;
+}
+
+void Tracer::count(const char* name, double delta)
+{
+    if (!isEnabled())
+        return;
+
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.lock);
+    double total = delta;
+    bool found = false;
+    for (auto& counter : buffer.counters)
+    {
+        if (counter.first == name)
+        {
+            counter.second += delta;
+            total = counter.second;
+            found = true;
+            break;
+        }
+    }
+    if (!found)
+        buffer.counters.emplace_back(name, delta);
+    buffer.events.push_back(Event{ name, "counter", 'C', now(), 0, name, total });
+}
+
+void Tracer::setThreadName(const std::string& threadName)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.lock);
+    buffer.threadName = threadName;
+}
+
+long long Tracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Tracer::complete(const char* name, const char* category, long long start, long long end,
+    const char* argName, double argValue)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.lock);
+    buffer.events.push_back(Event{ name, category, 'X', start, end - start, argName, argValue });
+}
+
+bool Tracer::write(const std::string& fileName)
+{
+    FILE* file = fopen(fileName.c_str(), "w");
+    if (!file)
+        return false;
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    bool isFirst = true;
+    std::lock_guard<std::mutex> registry(registryLock);
+    for (const std::shared_ptr<ThreadBuffer>& buffer : buffers)
+    {
+        std::lock_guard<std::mutex> lock(buffer->lock);
+        if (!buffer->threadName.empty())
+        {
+            fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                isFirst ? "" : ",", buffer->tid);
+            writeString(file, buffer->threadName.c_str());
+            fputs("}}", file);
+            isFirst = false;
+        }
+
+        for (const Event& event : buffer->events)
+        {
+            fprintf(file, "%s\n{\"name\":", isFirst ? "" : ",");
+            writeString(file, event.name);
+            fputs(",\"cat\":", file);
+            writeString(file, event.category);
+            fprintf(file, ",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%lld", event.phase, buffer->tid, event.ts);
+            if (event.phase == 'X')
+                fprintf(file, ",\"dur\":%lld", event.dur);
+            else
+                fprintf(file, ",\"id\":%d", buffer->tid);  //one counter track per thread
+            if (event.argName)
+            {
+                fputs(",\"args\":{", file);
+                writeString(file, event.argName);
+                fprintf(file, ":%.17g}", event.argValue);
+            }
+            fputc('}', file);
+            isFirst = false;
+        }
+    }
+    fputs("\n]}\n", file);
+    return fclose(file) == 0;
+}
+
+void Tracer::clear()
+{
+    std::lock_guard<std::mutex> registry(registryLock);
+    for (const std::shared_ptr<ThreadBuffer>& buffer : buffers)
+    {
+        std::lock_guard<std::mutex> lock(buffer->lock);
+        buffer->events.clear();
+        buffer->counters.clear();
+    }
+}
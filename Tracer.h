@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+/*
+* Tracer records spans and counters per thread and writes them as Chrome
+* trace JSON (chrome://tracing, ui.perfetto.dev). Names and categories
+* must be string literals, only their pointers are kept. Disabled, a span
+* costs one relaxed atomic load; enabled, an event is appended to the
+* buffer of its thread without contention with other threads.
+*/
+class Tracer
+{
+public:
+	/* a complete event from construction to close() or destruction */
+	class Span
+	{
+	public:
+		explicit Span(const char* name, const char* category = "qcc")
+			: name(name), category(category), argName(nullptr), argValue(0.0),
+			start(Tracer::isEnabled() ? Tracer::now() : -1)
+		{
+		}
+		~Span()
+		{
+			close();
+		}
+
+		/* one numeric argument shown with the span, e.g. a triangle count */
+		void arg(const char* key, double value)
+		{
+			argName = key;
+			argValue = value;
+		}
+		void close();
+
+	private:
+		const char* name;
+		const char* category;
+		const char* argName;
+		double argValue;
+		long long start;
+	};
+
+public:
+	static bool isEnabled()
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+	static void setEnabled(bool isOn);
+
+	/* adds delta to this thread's counter, drawn as one track per thread */
+	static void count(const char* name, double delta = 1.0);
+	static void setThreadName(const std::string& threadName);
+
+	/* microseconds since the process started tracing */
+	static long long now();
+	static bool write(const std::string& fileName);
+	static void clear();
+
+private:
+	static void complete(const char* name, const char* category, long long start, long long end,
+		const char* argName, double argValue);
+
+	static std::atomic<bool> enabled;
+};
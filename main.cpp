@@ -1,10 +1,32 @@
 #include "Qcc.h"
+#include "BatchRunner.h"
+#include "Tracer.h"
 #include <QApplication>
+#include <QCoreApplication>
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
-    Qcc w;
-    w.show();
-    return a.exec();
+    /* QCC_TRACE=trace.json records the whole session */
+    std::string traceFile = qgetenv("QCC_TRACE").toStdString();
+    Tracer::setEnabled(!traceFile.empty());
+
+    int ret = 0;
+    /* Qcc --batch job.json: no window and no GL context */
+    if (argc > 2 && QString(argv[1]) == "--batch")
+    {
+        QCoreApplication a(argc, argv);
+        ret = BatchRunner::exec(QString::fromLocal8Bit(argv[2]));
+    }
+    else
+    {
+        QApplication a(argc, argv);
+        Tracer::setThreadName("ui");
+        Qcc w;
+        w.show();
+        ret = a.exec();
+    }
+
+    if (!traceFile.empty())
+        Tracer::write(traceFile);
+    return ret;
 }